@@ -0,0 +1,330 @@
+/* Ribeira | Written in 2022 by NunoLealF
+   To the extent possible under law, NunoLealF has waived all copyright and related or neighboring rights to this
+   software to the public domain worldwide. This software is distributed without any warranty.
+
+   You should have received a copy of the CC0 Public Domain Dedication along with this software.
+   If not, see <http://creativecommons.org/publicdomain/zero/1.0/>. */
+
+// WARNING: This is 16-bit C code. You should compile this, along with any other files from the second stage
+// bootloader, with the -m16 (or equivalent) flag.
+
+#include "Stdint.h"
+#include "Memory.h"
+#include "Disk.h"
+#include "Archive.h"
+#include "Unreal.h"
+
+/*  ArchiveHeaderStruct: This is a struct that defines the header of the module archive, which is followed by its index.
+
+    uint32 Signature                                 - This is always ArchiveSignature ('RBAR').
+
+    uint16 Version                                   - This is always ArchiveVersion.
+
+    uint16 Count                                     - The amount of modules in the archive (and entries in the index).
+
+    uint32 Sectors                                   - The size of the whole archive, in sectors.
+
+    uint32 IndexChecksum                             - A checksum (from Checksum()) of every entry in the index.
+
+    ArchiveEntryStruct Index[]                       - The index, which has one entry for every module, sorted by name.
+
+    ArchiveEntryStruct: This is a struct that defines an entry in the index of the module archive.
+
+    char Name[32]                                    - The name of the module, padded with null bytes. Entries are
+                                                     sorted by this name, comparing each byte as an unsigned number.
+
+    uint32 Offset                                    - The offset of the module, in sectors, from the start of the
+                                                     archive. Every module starts on a new sector.
+
+    uint32 Length                                    - The length of the module, in bytes.
+
+    uint32 Checksum                                  - A checksum (from Checksum()) of the module.
+
+    uint16 Compression                               - How the module is compressed. Only CompressionNone (0) is
+                                                     supported for now.
+
+    The archive is made by the packer in Tools/Pack.c, which is built and run by the makefile. The header and the
+    index always fit in the first few sectors of the archive, so they can be read in one go, and after that, any
+    module can be found with a binary search, and loaded with one contiguous read.
+
+*/
+
+static bool ArchiveOpen = false;
+
+
+
+/*  CompareName(): Compares the name of a module with a string.
+
+    Input:        volatile char* Name                - The name of the module, from the index.
+
+    Input:        const char* String                 - The string you want to compare it with.
+
+    Output:       int                                - This returns 0 if they're the same, a negative value if the name
+                                                     comes before the string, or a positive value if it comes after.
+
+    This function compares the name of a module with a string, byte by byte (as unsigned numbers), which is the same
+    order the packer sorts the index in.
+    As this is a static function, it is not accessible outside of this file.
+
+*/
+
+static int CompareName(volatile char* Name, const char* String) {
+
+  for (int i = 0; i < 32; i++) {
+
+    if ((uint8)Name[i] != (uint8)String[i]) return ((uint8)Name[i] - (uint8)String[i]);
+    if (Name[i] == '\0') return 0;
+
+  }
+
+  return (String[32] == '\0') ? 0 : -1;
+
+}
+
+
+
+/*  OpenArchive(): Reads the header and index of the module archive into memory.
+
+    Output:       bool                               - This returns true if there's a valid module archive, and false
+                                                     if there isn't (or if it couldn't be read).
+
+    This function reads the header and index of the module archive (at ArchiveSector) into ArchiveIndex, and checks
+    that the signature, version, amount of modules and the checksum of the index are valid. It only needs to be called
+    once; after that, FindModule() and LoadModule() can be used without reading the index again.
+
+*/
+
+bool OpenArchive(void) {
+
+  ArchiveHeaderStruct* Header = (ArchiveHeaderStruct*)ArchiveIndex;
+  ArchiveOpen = false;
+
+  if (ReadSectors(ArchiveSector, 1, ArchiveIndex) != true) return false;
+
+  if ((Header->Signature != ArchiveSignature) || (Header->Version != ArchiveVersion)) return false;
+  if (Header->Count > ArchiveMaxEntries) return false;
+
+  // Read the rest of the index (if it doesn't fit in the first sector), and check it.
+
+  uint32 IndexSize = Header->Count * sizeof(ArchiveEntryStruct);
+  uint32 Sectors = (sizeof(ArchiveHeaderStruct) + IndexSize + 511) / 512;
+
+  if ((Sectors > 1) && (ReadSectors(ArchiveSector + 1, Sectors - 1, ArchiveIndex + 512) != true)) return false;
+  if (Checksum((void*)Header->Index, IndexSize) != Header->IndexChecksum) return false;
+
+  ArchiveOpen = true;
+  return true;
+
+}
+
+
+
+/*  FindModule(): Finds a module in the index of the module archive.
+
+    Input:        const char* Name                   - The name of the module you want to find.
+
+    Output:       ArchiveEntryStruct*                - The entry of the module in the index, or 0 if it isn't there.
+
+    This function finds a module in the index by doing a binary search on it, which only takes a handful of
+    comparisons, even with a full index. The archive must have been opened with OpenArchive() first.
+
+*/
+
+ArchiveEntryStruct* FindModule(const char* Name) {
+
+  ArchiveHeaderStruct* Header = (ArchiveHeaderStruct*)ArchiveIndex;
+
+  if (ArchiveOpen != true) return 0;
+
+  uint32 Low = 0;
+  uint32 High = Header->Count;
+
+  while (Low < High) {
+
+    uint32 Middle = Low + ((High - Low) / 2);
+    int Comparison = CompareName(Header->Index[Middle].Name, Name);
+
+    if (Comparison == 0) {
+
+      return &Header->Index[Middle];
+
+    } else if (Comparison < 0) {
+
+      Low = Middle + 1;
+
+    } else {
+
+      High = Middle;
+
+    }
+
+  }
+
+  return 0;
+
+}
+
+
+
+/*  StartModule(): Starts loading a module from the module archive.
+
+    Input:        const char* Name                   - The name of the module you want to load.
+
+    Output:       ModuleLoadStruct* Load             - This keeps track of the module while it's being loaded; pass it
+                                                     on to ContinueModule() and FinishModule().
+
+    Output:       bool                               - This returns true if the module can be loaded, and false if it
+                                                     can't (if it isn't there, or if there isn't enough memory for it).
+
+    This function finds a module in the archive, and allocates memory for it (aligned to 4KiB) with Allocate(), but it
+    doesn't read anything yet. That way, a module can be read a few sectors at a time (for example, in the background
+    while the boot menu is being shown), with ContinueModule().
+
+    The allocator must have been initialized with InitializeAllocator() first.
+
+*/
+
+bool StartModule(const char* Name, ModuleLoadStruct* Load) {
+
+  ArchiveEntryStruct* Entry = FindModule(Name);
+
+  Load->Entry = Entry;
+  Load->Address = 0;
+  Load->Done = 0;
+  Load->State = LoadFailed;
+
+  if ((Entry == 0) || (Entry->Compression != CompressionNone)) return false;
+
+  uint32 Address = Allocate(Entry->Length, 4096);
+  if ((Address == 0) && (Entry->Length != 0)) return false;
+
+  Load->Address = Address;
+  Load->State = LoadReading;
+
+  return true;
+
+}
+
+
+
+/*  ContinueModule(): Reads the next part of a module that's being loaded.
+
+    Input:        ModuleLoadStruct* Load             - The module you want to continue loading, from StartModule().
+
+    Input:        uint32 MaxSectors                  - The most sectors you want to read in this call. This is also
+                                                     limited to what the buffer can hold (ArchiveBufferSectors).
+
+    Output:       uint8                              - The state of the module after this call; LoadReading if there's
+                                                     still more to read, LoadDone if it's been loaded, or LoadFailed if
+                                                     it couldn't be read, or if its checksum doesn't match.
+
+    As the BIOS can only read into memory under 1MiB, each read goes through the 64KiB buffer at ArchiveBuffer, and
+    then gets copied to the allocated memory with MemcpyFar(), a dword at a time. Once the whole module has been
+    read, its checksum is checked.
+
+*/
+
+uint8 ContinueModule(ModuleLoadStruct* Load, uint32 MaxSectors) {
+
+  if (Load->State != LoadReading) return Load->State;
+
+  uint32 Length = Load->Entry->Length;
+  uint32 Done = Load->Done;
+
+  if (Done < Length) {
+
+    uint32 Sectors = ((Length - Done) + 511) / 512;
+
+    if (Sectors > MaxSectors) Sectors = MaxSectors;
+    if (Sectors > ArchiveBufferSectors) Sectors = ArchiveBufferSectors;
+
+    // Modules start on a new sector, and everything but the last read is a whole number of sectors, so Done is
+    // always a multiple of 512 here.
+
+    if (ReadSectors(ArchiveSector + Load->Entry->Offset + (Done / 512), Sectors, ArchiveBuffer) != true) {
+
+      Load->State = LoadFailed;
+      return LoadFailed;
+
+    }
+
+    // Some BIOSes switch to protected mode for disk reads, which resets the segment limits, so go back into unreal
+    // mode before copying anything above 1MiB (see EnterUnrealMode()).
+
+    EnterUnrealMode();
+
+    uint32 Size = ((Length - Done) < (Sectors * 512)) ? (Length - Done) : (Sectors * 512);
+    MemcpyFar(Load->Address + Done, ArchiveBuffer, Size);
+
+    Load->Done = Done + Size;
+
+  }
+
+  if (Load->Done >= Length) {
+
+    bool Valid = (Checksum((void*)Load->Address, Length) == Load->Entry->Checksum);
+    Load->State = (Valid == true) ? LoadDone : LoadFailed;
+
+  }
+
+  return Load->State;
+
+}
+
+
+
+/*  FinishModule(): Reads the rest of a module that's being loaded.
+
+    Input:        ModuleLoadStruct* Load             - The module you want to finish loading, from StartModule().
+
+    Output:       ModuleStruct* Module               - If the module was loaded, this is filled out with its name, the
+                                                     address it was loaded at, and its length.
+
+    Output:       bool                               - This returns true if the module was loaded, and false if it
+                                                     wasn't.
+
+    This function calls ContinueModule() until the module has been read, with as few BIOS calls as possible (127
+    sectors at a time). If the module was already read in the background, this only fills out Module.
+
+*/
+
+bool FinishModule(ModuleLoadStruct* Load, ModuleStruct* Module) {
+
+  while (ContinueModule(Load, ArchiveBufferSectors) == LoadReading);
+
+  if (Load->State != LoadDone) return false;
+
+  for (int i = 0; i < 32; i++) Module->Name[i] = Load->Entry->Name[i];
+  Module->Address = Load->Address;
+  Module->Length = Load->Entry->Length;
+
+  return true;
+
+}
+
+
+
+/*  LoadModule(): Loads a module from the module archive into memory.
+
+    Input:        const char* Name                   - The name of the module you want to load.
+
+    Output:       ModuleStruct* Module               - If the module was loaded, this is filled out with its name, the
+                                                     address it was loaded at, and its length.
+
+    Output:       bool                               - This returns true if the module was loaded, and false if it
+                                                     wasn't (if it isn't there, if there isn't enough memory, if it
+                                                     couldn't be read, or if its checksum doesn't match).
+
+    This function loads a module in one go, with StartModule() and FinishModule(). The allocator must have been
+    initialized with InitializeAllocator() first.
+
+*/
+
+bool LoadModule(const char* Name, ModuleStruct* Module) {
+
+  ModuleLoadStruct Load;
+
+  if (StartModule(Name, &Load) != true) return false;
+  return FinishModule(&Load, Module);
+
+}
@@ -0,0 +1,82 @@
+/* Ribeira | Written in 2022 by NunoLealF
+   To the extent possible under law, NunoLealF has waived all copyright and related or neighboring rights to this
+   software to the public domain worldwide. This software is distributed without any warranty.
+
+   You should have received a copy of the CC0 Public Domain Dedication along with this software.
+   If not, see <http://creativecommons.org/publicdomain/zero/1.0/>. */
+
+// WARNING: This is 16-bit C code. You should compile this, along with any other files from the second stage
+// bootloader, with the -m16 (or equivalent) flag.
+
+#ifndef _ARCHIVE_H_
+#define _ARCHIVE_H_
+
+// The module archive starts right after the overlays (at LBA 128), and it's made by Tools/Pack.c. Its header and
+// index are kept at 3000h in memory (which limits it to 64 modules), and modules are read 127 sectors at a time into
+// the 64KiB buffer at 10000h, before being copied to wherever they were allocated.
+
+#define ArchiveSector         128
+#define ArchiveSignature      0x52414252
+#define ArchiveVersion        1
+#define ArchiveMaxEntries     64
+#define ArchiveIndex          0x3000
+#define ArchiveBuffer         0x10000
+#define ArchiveBufferSectors  127
+
+#define CompressionNone       0
+
+// These are the states of a module that's being loaded with StartModule() and ContinueModule().
+
+#define LoadReading           0
+#define LoadDone              1
+#define LoadFailed            2
+
+typedef volatile struct _ArchiveEntryStruct_ {
+
+  char                    Name[32];
+  uint32                  Offset;
+  uint32                  Length;
+  uint32                  Checksum;
+  uint16                  Compression;
+  uint16                  Reserved;
+
+} __attribute__((packed)) ArchiveEntryStruct;
+
+typedef volatile struct _ArchiveHeaderStruct_ {
+
+  uint32                  Signature;
+  uint16                  Version;
+  uint16                  Count;
+  uint32                  Sectors;
+  uint32                  IndexChecksum;
+  ArchiveEntryStruct      Index[];
+
+} __attribute__((packed)) ArchiveHeaderStruct;
+
+typedef volatile struct _ModuleStruct_ {
+
+  char                    Name[32];
+  uint32                  Address;
+  uint32                  Length;
+
+} __attribute__((packed)) ModuleStruct;
+
+typedef volatile struct _ModuleLoadStruct_ {
+
+  ArchiveEntryStruct*     Entry;
+  uint32                  Address;
+  uint32                  Done;
+  uint8                   State;
+
+} __attribute__((packed)) ModuleLoadStruct;
+
+bool OpenArchive(void);
+
+ArchiveEntryStruct* FindModule(const char* Name);
+
+bool StartModule(const char* Name, ModuleLoadStruct* Load);
+uint8 ContinueModule(ModuleLoadStruct* Load, uint32 MaxSectors);
+bool FinishModule(ModuleLoadStruct* Load, ModuleStruct* Module);
+bool LoadModule(const char* Name, ModuleStruct* Module);
+
+#endif
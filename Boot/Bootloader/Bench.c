@@ -0,0 +1,230 @@
+/* Ribeira | Written in 2022 by NunoLealF
+   To the extent possible under law, NunoLealF has waived all copyright and related or neighboring rights to this
+   software to the public domain worldwide. This software is distributed without any warranty.
+
+   You should have received a copy of the CC0 Public Domain Dedication along with this software.
+   If not, see <http://creativecommons.org/publicdomain/zero/1.0/>. */
+
+// WARNING: This is 16-bit C code. You should compile this, along with any other files from the second stage
+// bootloader, with the -m16 (or equivalent) flag.
+
+#include "Stdint.h"
+#include "Memory.h"
+#include "Bench.h"
+
+/*  ReadTsc(): Reads the time stamp counter.
+
+    Output:       uint64                             - The amount of cycles since the CPU was reset.
+
+    The TSC is available on every CPU we support (Pentium Pro and up). Keep in mind that, under emulation, it doesn't
+    always count real cycles, so results are only comparable between runs with the same configuration.
+
+*/
+
+uint64 ReadTsc(void) {
+
+  uint64 Tsc;
+  __asm__ volatile("rdtsc" : "=A" (Tsc));
+
+  return Tsc;
+
+}
+
+
+
+// Everything else in this file is only used by benchmark builds, so it's left out of normal builds entirely, to keep
+// it out of the core of the 2nd stage bootloader. ReadTsc() is always there, since the boot log uses it too.
+
+#if (Benchmark != 0)
+
+/*  PhaseStart, PhaseCycles: These are the TSC values at the start of every phase, and the amount of cycles each
+    phase has taken so far. A phase can be started and stopped more than once, in which case the cycles add up.
+
+    PhaseName: These are the names of every phase, as they're sent over the serial port. The Tools/Bench.sh script
+    expects these names, so if you change them, you should change the baseline as well.
+
+*/
+
+static uint64 PhaseStart[BenchPhaseCount];
+static uint64 PhaseCycles[BenchPhaseCount];
+
+static const char* PhaseName[BenchPhaseCount] = {"sectors", "cache", "e820", "terminal", "total"};
+
+
+
+/*  Outb(), Inb(): Writes or reads a byte to/from an I/O port.
+
+    Input:        uint16 Port                        - The I/O port you want to write to or read from.
+
+    Input:        uint8 Value                        - (Outb only) The byte you want to write.
+
+    Output:       uint8                              - (Inb only) The byte that was read.
+
+    As these are static functions, they are not accessible outside of this file.
+
+*/
+
+static void Outb(uint16 Port, uint8 Value) {
+
+  __asm__ volatile("outb %0, %1" : : "a" (Value), "Nd" (Port));
+
+}
+
+static uint8 Inb(uint16 Port) {
+
+  uint8 Value;
+  __asm__ volatile("inb %1, %0" : "=a" (Value) : "Nd" (Port));
+
+  return Value;
+
+}
+
+
+
+/*  InitializeSerial(): Initializes the first serial port (COM1).
+
+    (No inputs or outputs)
+
+    This function sets COM1 up for 115200 baud, with 8 data bits, no parity and one stop bit (8N1), with its FIFO
+    enabled and its interrupts disabled.
+
+*/
+
+void InitializeSerial(void) {
+
+  Outb(SerialPort + 1, 0x00);
+  Outb(SerialPort + 3, 0x80);
+  Outb(SerialPort + 0, 0x01);
+  Outb(SerialPort + 1, 0x00);
+  Outb(SerialPort + 3, 0x03);
+  Outb(SerialPort + 2, 0xC7);
+  Outb(SerialPort + 4, 0x03);
+
+}
+
+
+
+/*  SerialPrint(): Sends a string over the first serial port (COM1).
+
+    Input:        const char* String                 - The (null-terminated) string you want to send.
+
+    This function sends every character in String over COM1, waiting for the transmitter to be empty before each one.
+    Unlike Print(), newlines are just '\n'.
+
+*/
+
+void SerialPrint(const char* String) {
+
+  for (uint32 i = 0; String[i] != '\0'; i++) {
+
+    while ((Inb(SerialPort + 5) & 0x20) == 0);
+    Outb(SerialPort, String[i]);
+
+  }
+
+}
+
+
+
+/*  InitializeBenchmark(): Gets everything ready for timing the boot process.
+
+    (No inputs or outputs)
+
+    This function initializes COM1 and clears out the amount of cycles of every phase. It should be called as early
+    as possible, as nothing before it can be timed (other than the bootsector, which saves its own timings).
+
+*/
+
+void InitializeBenchmark(void) {
+
+  InitializeSerial();
+
+  Memset((void*)PhaseStart, 0, sizeof(PhaseStart));
+  Memset((void*)PhaseCycles, 0, sizeof(PhaseCycles));
+
+}
+
+
+
+/*  StartPhase(), StopPhase(): Starts or stops timing a phase of the boot process.
+
+    Input:        uint8 Phase                        - The phase you want to start or stop timing, like BenchE820.
+
+    These are normally used through the BenchStart() and BenchStop() macros, which do nothing in regular builds.
+
+*/
+
+void StartPhase(uint8 Phase) {
+
+  PhaseStart[Phase] = ReadTsc();
+
+}
+
+void StopPhase(uint8 Phase) {
+
+  PhaseCycles[Phase] += ReadTsc() - PhaseStart[Phase];
+
+}
+
+
+
+/*  ReportBenchmark(): Sends the amount of cycles every phase took over the serial port.
+
+    (No inputs or outputs)
+
+    This function works out the timings of the bootsector (from the TSC values it left at BenchBootStart and
+    BenchBootLoaded) and the total time since the bootsector started, and then sends one line for every phase over
+    COM1, like "BENCH e820 00000000001A2B3C". The amount of cycles is in hexadecimal, so that we don't need 64-bit
+    division (which would need libgcc).
+
+*/
+
+void ReportBenchmark(void) {
+
+  uint64 BootStart = *(volatile uint64*)BenchBootStart;
+
+  PhaseCycles[BenchSectors] = *(volatile uint64*)BenchBootLoaded - BootStart;
+  PhaseCycles[BenchTotal] = ReadTsc() - BootStart;
+
+  for (uint8 Phase = 0; Phase < BenchPhaseCount; Phase++) {
+
+    char Hex[18];
+
+    for (int i = 0; i < 16; i++) {
+
+      uint8 Digit = (PhaseCycles[Phase] >> ((15 - i) * 4)) & 0x0F;
+      Hex[i] = (Digit < 10) ? ('0' + Digit) : ('A' + Digit - 10);
+
+    }
+
+    Hex[16] = '\n';
+    Hex[17] = '\0';
+
+    SerialPrint("BENCH ");
+    SerialPrint(PhaseName[Phase]);
+    SerialPrint(" ");
+    SerialPrint(Hex);
+
+  }
+
+}
+
+
+
+/*  ExitBenchmark(): Exits Qemu with an exit code.
+
+    Input:        uint8 Code                         - Either BenchPassed or BenchFailed.
+
+    This function writes Code to the isa-debug-exit device (at BenchExitPort), which makes Qemu exit with the status
+    (Code * 2) + 1. If it isn't there (for example, on real hardware), this just halts the system instead.
+
+*/
+
+void ExitBenchmark(uint8 Code) {
+
+  Outb(BenchExitPort, Code);
+  for(;;);
+
+}
+
+#endif
@@ -0,0 +1,58 @@
+/* Ribeira | Written in 2022 by NunoLealF
+   To the extent possible under law, NunoLealF has waived all copyright and related or neighboring rights to this
+   software to the public domain worldwide. This software is distributed without any warranty.
+
+   You should have received a copy of the CC0 Public Domain Dedication along with this software.
+   If not, see <http://creativecommons.org/publicdomain/zero/1.0/>. */
+
+// WARNING: This is 16-bit C code. You should compile this, along with any other files from the second stage
+// bootloader, with the -m16 (or equivalent) flag.
+
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+// Benchmark builds (set with the BENCH variable in the makefile) time each phase of the boot process with the TSC,
+// and send the results over the first serial port (COM1), before exiting Qemu with its isa-debug-exit device. The
+// bootsector saves the TSC before and after loading the core, at 7C60h and 7C68h (in the unused part of the BPB).
+
+#ifndef Benchmark
+  #define Benchmark 0
+#endif
+
+#define BenchBootStart     0x7C60
+#define BenchBootLoaded    0x7C68
+
+#define SerialPort         0x3F8
+#define BenchExitPort      0xF4
+#define BenchPassed        0x10
+#define BenchFailed        0x11
+
+#define BenchSectors       0
+#define BenchCache         1
+#define BenchE820          2
+#define BenchTerminal      3
+#define BenchTotal         4
+#define BenchPhaseCount    5
+
+// These only do anything in benchmark builds, so they can be left in the code.
+
+#if (Benchmark != 0)
+  #define BenchStart(Phase)  StartPhase(Phase)
+  #define BenchStop(Phase)   StopPhase(Phase)
+#else
+  #define BenchStart(Phase)
+  #define BenchStop(Phase)
+#endif
+
+uint64 ReadTsc(void);
+
+void InitializeSerial(void);
+void SerialPrint(const char* String);
+
+void InitializeBenchmark(void);
+void StartPhase(uint8 Phase);
+void StopPhase(uint8 Phase);
+void ReportBenchmark(void);
+void ExitBenchmark(uint8 Code);
+
+#endif
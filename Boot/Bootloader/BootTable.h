@@ -0,0 +1,102 @@
+/* Ribeira | Written in 2022 by NunoLealF
+   To the extent possible under law, NunoLealF has waived all copyright and related or neighboring rights to this
+   software to the public domain worldwide. This software is distributed without any warranty.
+
+   You should have received a copy of the CC0 Public Domain Dedication along with this software.
+   If not, see <http://creativecommons.org/publicdomain/zero/1.0/>. */
+
+// WARNING: This is 16-bit C code. You should compile this, along with any other files from the second stage
+// bootloader, with the -m16 (or equivalent) flag.
+
+#ifndef _BOOTTABLE_H_
+#define _BOOTTABLE_H_
+
+// The BootTable is an 8KiB area at E000h in memory (up to FFFFh), which is where the 2nd stage bootloader puts
+// everything it finds out about the system, so that the kernel doesn't have to find it again. This needs Memory.h,
+// Archive.h and Log.h to be included first.
+
+// 8192 bytes
+// L/H Signature: 8 bytes    (8184 bytes remaining), 8
+// Version/Count: 4 bytes    (8180 bytes remaining), 12
+// Size:          4 bytes    (8176 bytes remaining), 16
+// Sections:      32 bytes   (8144 bytes remaining), 48
+// Memorymap:     3072 bytes (5072 bytes remaining), 3120
+// Memorymap-ec:  4 bytes    (5068 bytes remaining), 3124
+// Modulecount:   4 bytes    (5064 bytes remaining), 3128
+// Modules:       640 bytes  (4424 bytes remaining), 3768
+// Rsdp:          44 bytes   (4380 bytes remaining), 3812
+// Smbios:        40 bytes   (4340 bytes remaining), 3852
+// Edd:           82 bytes   (4258 bytes remaining), 3934
+// Log:           1800 bytes (2458 bytes remaining), 5734
+
+#define BootTableLocation       0xE000
+#define BootTableSize           8192
+#define BootTableLowSignature   0x333C6557
+#define BootTableHighSignature  0x31323665
+#define BootTableVersion        2
+
+// These are the sections in the BootTable, which are the indexes of Sections[]. A section that isn't there (for
+// example, if the system doesn't have ACPI) has an offset of zero.
+
+#define BootSectionMemoryMap    0
+#define BootSectionModules      1
+#define BootSectionRsdp         2
+#define BootSectionSmbios       3
+#define BootSectionEdd          4
+#define BootSectionLog          5
+#define BootSectionCount        8
+
+typedef volatile struct _BootSectionStruct_ {
+
+  uint16                  Offset;
+  uint16                  Size;
+
+} __attribute__((packed)) BootSectionStruct;
+
+typedef volatile struct _RsdpStruct_ {
+
+  uint32                  Address;
+  uint32                  Length;
+  uint8                   Table[36];
+
+} __attribute__((packed)) RsdpStruct;
+
+typedef volatile struct _SmbiosStruct_ {
+
+  uint32                  Address;
+  uint32                  Length;
+  uint8                   Table[32];
+
+} __attribute__((packed)) SmbiosStruct;
+
+typedef volatile struct _EddStruct_ {
+
+  uint32                  Drive;
+  uint32                  Length;
+  uint8                   Table[0x4A];
+
+} __attribute__((packed)) EddStruct;
+
+typedef volatile struct _BootTableType_ {
+
+  uint32                  LowSignature;
+  uint32                  HighSignature;
+  uint16                  Version;
+  uint16                  SectionCount;
+  uint32                  Size;
+  BootSectionStruct       Sections[BootSectionCount];
+
+  MemoryMapEntryStruct    MemoryMap[128];
+  uint32                  MemoryMapLastEntry;
+  uint32                  ModuleCount;
+  ModuleStruct            Modules[16];
+
+  RsdpStruct              Rsdp;
+  SmbiosStruct            Smbios;
+  EddStruct               Edd;
+
+  LogStruct               Log;
+
+} __attribute__((packed)) BootTableType;
+
+#endif
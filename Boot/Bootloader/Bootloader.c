@@ -11,29 +11,107 @@
 #include "Stdint.h"
 #include "Error.h"
 #include "Memory.h"
+#include "Archive.h"
+#include "Log.h"
+#include "BootTable.h"
+#include "Firmware.h"
 #include "Graphics.h"
+#include "Memtest.h"
+#include "Disk.h"
+#include "Cache.h"
+#include "Overlay.h"
+#include "Bench.h"
+#include "Interrupt.h"
+#include "Menu.h"
+#include "Unreal.h"
 
 #ifndef __i686__
 #error  "You must compile this on a cross-compiler with an i686 target."
 #endif
 
-// 8192 bytes
-// L/H Signature: 8 bytes    (8184 bytes remaining), 8
-// Memorymap:     3072 bytes (5112 bytes remaining), 3080
-// Memorymap-ec:  4 bytes (5108 bytes remaining), 3084
+// The start and end of .bss, from Bootloader.ld.
 
-// ! KEEP IN MIND !
-// LOWSIGNATURE = 0x333C6557
-// HIGHSIGNATURE = 0x31323665
+extern char BssStart[];
+extern char BssEnd[];
 
-typedef volatile struct _BootTableType_ {
+/*  BootEntries: The entries in the boot menu, and the modules every one of them needs. The first one (BootEntryDefault)
+    is booted if nothing else is chosen before the countdown runs out, and its modules are read in the background
+    while the menu is being shown, so that most (or all) of them are already in memory by the time it's booted.
 
-  uint32                  LowSignature;
-  uint32                  HighSignature;
-  MemoryMapEntryStruct    MemoryMap[128];
-  uint32                  MemoryMapLastEntry;
+    Prefetch[]: The modules of the default entry that are being read in the background (in the same order as in its
+    entry). PrefetchSectors is how many sectors are read at a time, which is small enough to keep the menu responsive.
 
-} __attribute__((packed)) BootTableType;
+*/
+
+#define BootEntryDefault  0
+#define BootEntryCount    (sizeof(BootEntries) / sizeof(BootEntries[0]))
+#define PrefetchSectors   16
+
+static const BootEntryStruct BootEntries[] = {
+
+  {"Ribeira", {"Kernel", "Initrd", 0, 0}},
+  {"Ribeira (kernel only)", {"Kernel", 0, 0, 0}}
+
+};
+
+static ModuleLoadStruct Prefetch[MenuMaxModules];
+static uint8 PrefetchCount = 0;
+
+
+
+/*  PrefetchModules(): Reads the next few sectors of the default entry's modules.
+
+    Output:       bool                               - This returns true if there's still more to read, and false if
+                                                     every module has been read (or has failed).
+
+    This function is called by BootMenu() whenever it has nothing else to do, and it reads up to PrefetchSectors
+    sectors of the first module in Prefetch[] that hasn't been read yet.
+    As this is a static function, it is not accessible outside of this file.
+
+*/
+
+static bool PrefetchModules(void) {
+
+  for (uint8 i = 0; i < PrefetchCount; i++) {
+
+    if (Prefetch[i].State == LoadReading) {
+
+      ContinueModule(&Prefetch[i], PrefetchSectors);
+      return true;
+
+    }
+
+  }
+
+  return false;
+
+}
+
+
+
+/*  AddBootSection(): Adds a section to the section table of the BootTable.
+
+    Input:        BootTableType* BootTable           - The BootTable you want to add the section to.
+
+    Input:        uint8 Section                      - The number of the section, like BootSectionRsdp.
+
+    Input:        volatile void* Address             - The address of the section, which must be inside the BootTable.
+
+    Input:        uint32 Size                        - The size of the section, in bytes.
+
+    The section table (Sections[]) has the offset (from the start of the BootTable) and the size of every section, so
+    that the kernel can find any of them straight away, even if a later version of the BootTable moves them around.
+    Sections that are never added keep an offset of zero, which means they aren't there.
+    As this is a static function, it is not accessible outside of this file.
+
+*/
+
+static void AddBootSection(BootTableType* BootTable, uint8 Section, volatile void* Address, uint32 Size) {
+
+  BootTable->Sections[Section].Offset = (uint16)((uint32)Address - (uint32)BootTable);
+  BootTable->Sections[Section].Size = (uint16)Size;
+
+}
 
 
 
@@ -42,8 +120,10 @@ typedef volatile struct _BootTableType_ {
     Input:        unsigned long ErrorCode            - This specifies the error code to crash with.
 
     This function is a crash handler for the system, which should be called whenever there is a need to crash the
-    system. It gives out the error code, along with the associated message (defined in Error.h), and halts the
-    system. It doesn't disable interrupts, so you can still use Ctrl+Alt+Delete to restart the system in this state.
+    system. It shows every event in the boot log (including debug events, if the Log overlay can still be loaded),
+    gives out the error code, along with the associated message (defined in Error.h), and halts the system. It puts
+    the BIOS's interrupt handlers back, and doesn't disable interrupts, so you can still use Ctrl+Alt+Delete to
+    restart the system in this state.
 */
 
 void Crash(unsigned long ErrorCode) {
@@ -51,6 +131,14 @@ void Crash(unsigned long ErrorCode) {
   char ErrorCodeString[8];
   Itoa(ErrorCode, ErrorCodeString, 10);
 
+  RestoreInterrupts();
+
+  // The Log overlay is loaded beforehand, since RenderLog() would crash again (with error 3) if it couldn't be.
+
+  if (LoadOverlay(OverlayLog) == true) {
+    RenderLog(LogDebug);
+  }
+
   Print("\n\n\rUnable to continue booting (Error ", 0x0C);
   Print(ErrorCodeString, 0x07);
   Print("), halting the system. Reason given:\n\r", 0x0C);
@@ -59,6 +147,18 @@ void Crash(unsigned long ErrorCode) {
 
   Print("\n\n\rTo restart your system, press Ctrl+Alt+Delete.", 0x0F);
 
+  // In benchmark builds, let the benchmark script know that something went wrong, and exit Qemu.
+
+  #if (Benchmark != 0)
+
+    SerialPrint("BENCH crash ");
+    SerialPrint(ErrorCodeString);
+    SerialPrint("\n");
+
+    ExitBenchmark(BenchFailed);
+
+  #endif
+
   for(;;);
 
 }
@@ -75,64 +175,310 @@ void Crash(unsigned long ErrorCode) {
 
 void Bootloader(void) {
 
+  // Clear out .bss, since the bootsector only loads the sectors that have code and data in them (see Bootloader.ld).
+  // This has to come first, as every uninitialized global variable lives there.
+
+  Memset(BssStart, 0, (uint32)BssEnd - (uint32)BssStart);
+
+  // Switch into unreal mode, so that we can use 32-bit addresses past FFFFh (like the framebuffer at B8000h, or
+  // anything above 1MiB) without a general protection fault, and then enable the A20 line, so that memory above 1MiB
+  // doesn't wrap around to the start of memory.
+
+  EnterUnrealMode();
+  bool A20 = EnableA20();
+
+  // If this is a benchmark build (see Bench.h), get ready to time the rest of the boot process.
+
+  #if (Benchmark != 0)
+    InitializeBenchmark();
+  #endif
+
   // Allocate up to 8KiB space for the BootTable struct at E000h in memory, up to FFFFh, and initialize the table.
 
-  BootTableType *BootTable = (BootTableType*)0xE000;
+  BootTableType *BootTable = (BootTableType*)BootTableLocation;
+
+  MemsetFar((uint32)BootTable, 0, BootTableSize);
+
+  BootTable->LowSignature  = BootTableLowSignature;
+  BootTable->HighSignature = BootTableHighSignature;
+  BootTable->Version       = BootTableVersion;
+  BootTable->SectionCount  = BootSectionCount;
+  BootTable->Size          = sizeof(BootTableType);
+
+  // Initialize the boot log, which is also kept in the BootTable. Status messages are only logged here, and they're
+  // shown all at once at the end (or if we crash), instead of being printed as we go.
+
+  InitializeLog(&BootTable->Log);
+  LogEvent(EventStart, LogDebug, 0, 0, 0, 0);
+
+  if (A20 == true) {
+
+    LogEvent(EventUnreal, LogDebug, 0, 0, 0, 0);
 
-  Memset((void*)BootTable, 0, 8192);
+  } else {
 
-  BootTable->LowSignature  = 0x333C6557;
-  BootTable->HighSignature = 0x31323665;
+    LogEvent(EventNoA20, LogWarning, 0, 0, 0, 0);
+
+  }
 
   // Initialize the Terminal table, which is used for storing terminal data, and clear out the terminal.
   // Assuming a VGA 80x25 text mode here.
 
+  BenchStart(BenchTerminal);
   InitializeTerminal(80, 25, 2, 0xB8000);
+  BenchStop(BenchTerminal);
+
+  // Initialize the Disk table with the drive we booted from, which the bootsector saved for us, so that we can read
+  // and write sectors from/to it.
+
+  InitializeDisk(*(volatile uint8*)BootDriveLocation);
+  LogEvent(EventDisk, LogDebug, Disk.Drive, 0, 0, 0);
+
+  // If the probe cache (in the storage sectors of Boot.bin) was made on this same system, we can use the hardware
+  // data in it instead of probing everything again. Otherwise, probe the hardware, and store it in the cache.
+
+  ProbeKeyStruct ProbeKey;
+  uint32 LastEntry = 0;
+
+  // The SMBIOS entry point is part of the key, and it's also copied into the BootTable later on, so it's only
+  // scanned for once, here.
+
+  BenchStart(BenchCache);
+  uint32 SmbiosAddress = FindSmbiosEntryPoint();
+  GetProbeKey(&ProbeKey, MemtestLevel, SmbiosAddress);
+  bool CacheValid = LoadProbeCache(&ProbeKey, BootTable);
+  BenchStop(BenchCache);
+
+  if (CacheValid == true) {
+
+    LastEntry = BootTable->MemoryMapLastEntry;
+    LogEvent(EventCacheHit, LogInfo, LastEntry + 1, 0, 0, 0);
+
+  } else {
+
+    // Use the BIOS call int 15h e820h to get a memory map of the system, with up to 128 entries.
+
+    BenchStart(BenchE820);
+
+    for (int i = 0; i < 128; i++) {
+
+      uint32 MemoryMapReturnValue = GetMemoryMapEntry(&BootTable->MemoryMap[i], i);
+      LastEntry = i;
+
+      if (MemoryMapReturnValue == 0) {
+
+        break;
+
+      } else if (MemoryMapReturnValue == uint_max) {
+
+        Crash(1); break;
 
-  // Use the BIOS call int 15h e820h to get a memory map of the system, with up to 128 entries.
+      }
 
-  Print("Getting the system memory map.\n\r", 0x0F);
+    }
+
+    BenchStop(BenchE820);
+    LogEvent(EventE820, LogInfo, LastEntry + 1, 0, 0, 0);
+
+    // If it's enabled, test the usable memory from the memory map, so that any bad ranges are marked as bad memory
+    // (type 5) before anything else gets to use them. This is set with the MEMTEST variable in the makefile.
+
+    #if (MemtestLevel != MemtestOff)
+
+      MemtestResultStruct MemtestResult;
+
+      if (TestMemoryMap(BootTable->MemoryMap, &LastEntry, 128, MemtestLevel, &MemtestResult) == true) {
+
+        LogEvent(EventMemtest, (MemtestResult.BadRanges == 0) ? LogInfo : LogWarning,
+                 MemtestResult.TestedKiB / 1024, MemtestResult.Throughput, MemtestResult.BadRanges, 0);
+
+      } else {
+
+        LogEvent(EventMemtestSkipped, LogWarning, 0, 0, 0, 0);
+
+      }
+
+    #endif
+
+    BootTable->MemoryMapLastEntry = LastEntry;
+
+    // Ask the BIOS for the EDD parameters of the boot disk (with int 13h, ah 48h), which the kernel can use to work
+    // out which disk it was loaded from. These are kept in the probe cache along with the memory map.
+
+    if (GetDriveParameters((uint32)BootTable->Edd.Table, sizeof(BootTable->Edd.Table)) == true) {
+
+      BootTable->Edd.Drive = Disk.Drive;
+      BootTable->Edd.Length = *(volatile uint16*)BootTable->Edd.Table;
+
+      LogEvent(EventEdd, LogDebug, BootTable->Edd.Drive, BootTable->Edd.Length, 0, 0);
+
+    }
+
+    if (StoreProbeCache(&ProbeKey, BootTable) == true) {
+
+      LogEvent(EventCacheStored, LogDebug, 0, 0, 0, 0);
+
+    } else {
+
+      LogEvent(EventCacheNotStored, LogWarning, 0, 0, 0, 0);
+
+    }
+
+  }
+
+  // Find the ACPI RSDP, and keep a copy of it and of the SMBIOS entry point (which was found above), along with their
+  // addresses, so that the kernel doesn't have to scan for them again. Unlike the probes above, this is quick enough
+  // to do on every boot.
+
+  if (GetRsdp(&BootTable->Rsdp) == true) {
+
+    LogEvent(EventRsdp, LogDebug, BootTable->Rsdp.Address, BootTable->Rsdp.Table[15], 0, 0);
+
+  }
+
+  if (GetSmbios(&BootTable->Smbios, SmbiosAddress) == true) {
+
+    LogEvent(EventSmbios, LogDebug, BootTable->Smbios.Address, 0, 0, 0);
+
+  }
+
+  // Initialize the allocator with the memory map, and open the module archive (if there is one), so that we can load
+  // any modules we need from it. Only the modules we ask for are actually read from the disk. Modules always go
+  // above 1MiB, so if the A20 line couldn't be enabled, they can't be loaded at all.
+
+  InitializeAllocator(BootTable->MemoryMap, LastEntry);
+
+  if ((A20 == true) && (OpenArchive() == true)) {
+
+    // Start loading the modules of the default entry, and show the boot menu. While the countdown is running, the
+    // modules are read in the background (by PrefetchModules()), so the wait isn't wasted. If there's no countdown
+    // (MenuTimeout is 0), only one entry, or none of the default entry's modules are in the archive, there's nothing
+    // to wait for, so the menu is skipped altogether, without reading its overlay.
 
-  for (int i = 0; i < 128; i++) {
+    const BootEntryStruct* Entry = &BootEntries[BootEntryDefault];
+    uint8 Prefetching = 0;
+    PrefetchCount = 0;
 
-    uint32 MemoryMapReturnValue = GetMemoryMapEntry(&BootTable->MemoryMap[i], i);
-    BootTable->MemoryMapLastEntry = i;
+    while ((PrefetchCount < MenuMaxModules) && (Entry->Modules[PrefetchCount] != 0)) {
 
-    if (MemoryMapReturnValue == 0) {
+      if (StartModule(Entry->Modules[PrefetchCount], &Prefetch[PrefetchCount]) == true) Prefetching++;
+      PrefetchCount++;
 
-      break;
+    }
 
-    } else if (MemoryMapReturnValue == uint_max) {
+    // The Menu overlay is loaded beforehand, so that if it can't be read, the default entry is booted instead of
+    // crashing.
 
-      Crash(1); break;
+    uint8 Chosen = BootEntryDefault;
 
+    if ((MenuTimeout != 0) && (BootEntryCount > 1) && (Prefetching > 0) && (LoadOverlay(OverlayMenu) == true)) {
+      Chosen = BootMenu(BootEntries, BootEntryCount, BootEntryDefault, MenuTimeout, PrefetchModules);
     }
 
+    uint8 Resident = 0;
+    uint8 Needed = 0;
+
+    // Load every module of the chosen entry. If a module was already (or partly) read in the background, only the
+    // rest of it has to be read now; otherwise (or if reading it in the background failed), it's loaded from scratch.
+
+    Entry = &BootEntries[Chosen];
+
+    for (uint8 i = 0; (i < MenuMaxModules) && (Entry->Modules[i] != 0); i++) {
+
+      ArchiveEntryStruct* ArchiveEntry = FindModule(Entry->Modules[i]);
+      ModuleLoadStruct* Load = 0;
+      ModuleLoadStruct Fresh;
+
+      Needed++;
+
+      for (uint8 j = 0; j < PrefetchCount; j++) {
+
+        if ((ArchiveEntry == 0) || (Prefetch[j].Entry != ArchiveEntry)) continue;
+        if ((Prefetch[j].State == LoadReading) || (Prefetch[j].State == LoadDone)) Load = &Prefetch[j];
+
+      }
+
+      if (Load == 0) {
+
+        Load = &Fresh;
+        StartModule(Entry->Modules[i], Load);
+
+      } else if (Load->State == LoadDone) {
+
+        Resident++;
+
+      }
+
+      ModuleStruct* Module = &BootTable->Modules[BootTable->ModuleCount];
+
+      if ((BootTable->ModuleCount < 16) && (FinishModule(Load, Module) == true)) {
+
+        BootTable->ModuleCount++;
+        LogEvent(EventModule, LogInfo, Module->Address, Module->Length, i, 0);
+
+      } else {
+
+        LogEvent(EventNoModule, LogWarning, i, 0, 0, 0);
+
+      }
+
+    }
+
+    LogEvent(EventMenu, LogInfo, Chosen, Resident, Needed, 0);
+
+  } else if (A20 == true) {
+
+    LogEvent(EventNoArchive, LogWarning, 0, 0, 0, 0);
+
   }
 
-  // Warning: Literally all the code in this function and like half of the code otherwise in this file is incomplete
+  // Fill out the section table, so that the kernel can find everything in the BootTable in one step.
+
+  uint32 MemoryMapSize = (LastEntry + 1) * sizeof(MemoryMapEntryStruct);
+  uint32 ModulesSize = BootTable->ModuleCount * sizeof(ModuleStruct);
 
-  int freeram = 0; // THIS MEASURES RAM UNDER 4GB AND NOT EVEN PROPERLY
+  AddBootSection(BootTable, BootSectionMemoryMap, BootTable->MemoryMap, MemoryMapSize);
+  AddBootSection(BootTable, BootSectionModules, BootTable->Modules, ModulesSize);
 
-  for (uint32 i = 0; i <= BootTable->MemoryMapLastEntry; i++) {
-    if (BootTable->MemoryMap[i].Type != 1) continue;
-    freeram += BootTable->MemoryMap[i].LowEntryLength;
+  if (BootTable->Rsdp.Address != 0) {
+    AddBootSection(BootTable, BootSectionRsdp, &BootTable->Rsdp, sizeof(RsdpStruct));
   }
 
-  freeram /= 1024;
+  if (BootTable->Smbios.Address != 0) {
+    AddBootSection(BootTable, BootSectionSmbios, &BootTable->Smbios, sizeof(SmbiosStruct));
+  }
+
+  if (BootTable->Edd.Length != 0) {
+    AddBootSection(BootTable, BootSectionEdd, &BootTable->Edd, sizeof(EddStruct));
+  }
+
+  AddBootSection(BootTable, BootSectionLog, &BootTable->Log, sizeof(LogStruct));
+
+  // Show the boot log (everything other than debug events), now that there's nothing else left to log. The code and
+  // the messages for this are in the Log overlay, which is loaded beforehand, so that if it can't be read, the log is
+  // just left out instead of crashing.
+
+  BenchStart(BenchTerminal);
+
+  if (LoadOverlay(OverlayLog) == true) {
+    RenderLog(LogInfo);
+  }
+
+  BenchStop(BenchTerminal);
+
+  // In benchmark builds, this is the end of the line; send the timings over the serial port, and exit Qemu.
+
+  #if (Benchmark != 0)
+
+    ReportBenchmark();
+    ExitBenchmark(BenchPassed);
 
-  char buffer[32]; Memset(buffer, 0, 32);
-  char thing[9]; Memcpy(thing, (void*)&BootTable->LowSignature, 8); thing[9] = '\0';
+  #endif
 
-  Print("Test: Bootloader is at ", 0x0F);
-  Itoa((unsigned long)&Bootloader, buffer, 16);
-  Print(buffer, 0x07); Print(".\n\rBootTable->LowSignature is at ", 0x0F);
-  Print(Itoa((unsigned long)&BootTable->LowSignature, buffer, 16), 0x07);
-  Print(".\n\rBootTable->MemoryMapLastEntry is at ", 0x0F); Print(Itoa((unsigned long)&BootTable->MemoryMapLastEntry, buffer, 16), 0x07);
-  Print(".\n\rTest 2: ", 0x0F); Print(Itoa(BootTable->LowSignature, buffer, 16), 0x07); Putchar(' ', 0x0F); Print(Itoa(BootTable->HighSignature, buffer, 16), 0x07);
-  Print(" Ascii: ", 0x0F); Print(thing, 0x07); Print("\n\n\rRibeira bootloader. Licensed as CC0.\n\n\rTODO:\n\r - Add support for the detection of, and enabling of the A20 Line, before E820\n\r(Challenges: We've got no machines with A20 off by default to test this out)\n\n\r - Add support for VBE\n\r(Challenges: Not sure yet, but don't set any modes in this stage yet)\n\n\rCPUID is only for protected mode, it won't work in real mode, trust me!\n\r19:04 15 May 2022 UTC+1", 0x9F);
+  // There's nothing to hand control over to yet, so this is where a normal boot ends. This doesn't go through Crash(),
+  // since nothing went wrong, and the boot log has already been shown once.
 
-  Crash(0);
+  Print("\n\n\rThe bootloader has finished, halting the system.", 0x0F);
 
   for(;;);
 
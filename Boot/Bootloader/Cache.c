@@ -0,0 +1,228 @@
+/* Ribeira | Written in 2022 by NunoLealF
+   To the extent possible under law, NunoLealF has waived all copyright and related or neighboring rights to this
+   software to the public domain worldwide. This software is distributed without any warranty.
+
+   You should have received a copy of the CC0 Public Domain Dedication along with this software.
+   If not, see <http://creativecommons.org/publicdomain/zero/1.0/>. */
+
+// WARNING: This is 16-bit C code. You should compile this, along with any other files from the second stage
+// bootloader, with the -m16 (or equivalent) flag.
+
+#include "Stdint.h"
+#include "Memory.h"
+#include "Archive.h"
+#include "Log.h"
+#include "BootTable.h"
+#include "Disk.h"
+#include "Firmware.h"
+#include "Cache.h"
+#include "Overlay.h"
+
+/*  ProbeKeyStruct: This is a struct that identifies the system that a probe cache was made on.
+
+    uint8 BiosDate[8]                                - The BIOS date string, from FFFF5h in memory (like "05/15/22").
+
+    uint8 BiosModel                                  - The system model byte, from FFFFEh in memory.
+
+    uint8 Memtest                                    - The memory test level (MemtestLevel) that the cache was made
+                                                     with, since the memory map depends on it.
+
+    uint8 Drive                                      - The BIOS drive number we booted from, since the EDD parameters
+                                                     depend on it.
+
+    uint32 SmbiosEntryChecksum                       - A checksum of the SMBIOS entry point, or 0 if there isn't one.
+
+    uint32 SmbiosTableChecksum                       - A checksum of (up to the first 4KiB of) the SMBIOS structure
+                                                     table, which has things like the system's UUID and serial number.
+
+    uint32 LowMemory, ExtendedMemory                 - The amount of conventional and extended memory in KiB, as given
+                                                     by int 12h and int 15h, ax e801h.
+
+    Every field here is cheap to get (much cheaper than going through E820 and testing memory), and together, they
+    should change whenever the firmware, the motherboard, or the amount of RAM in the system changes.
+
+    ProbeCacheStruct: This is a struct that contains a snapshot of the hardware data we got from the system.
+
+    uint32 Signature                                 - This is always CacheSignature ('RBPC').
+
+    uint16 Version                                   - This is always CacheVersion, which changes with this struct.
+
+    uint16 Size                                      - The amount of bytes of this struct that are actually used.
+
+    uint32 Checksum                                  - A checksum (from Checksum()) of the first Size bytes of this
+                                                     struct, calculated with this field set to zero.
+
+    ProbeKeyStruct Key                               - The key of the system that this snapshot was made on.
+
+    EddStruct Edd                                    - The EDD parameters of the boot disk, from int 13h, ah 48h. If
+                                                     the BIOS didn't give us any, then this is all zeroes.
+
+    uint32 MemoryMapLastEntry, MemoryMap[]           - The memory map, after it's been tested. Only the entries up to
+                                                     and including MemoryMapLastEntry are used.
+
+*/
+
+
+
+/*  GetProbeKey(): Fills out a ProbeKeyStruct for the current system.
+
+    Output:       ProbeKeyStruct* Key                - The key you want to fill out.
+
+    Input:        uint8 Memtest                      - The memory test level that's being used.
+
+    Input:        uint32 Smbios                      - The address of the SMBIOS entry point, from
+                                                     FindSmbiosEntryPoint(), or 0 if there isn't one.
+
+    This function gathers the information we use to identify the current system, and writes it to Key. It reads the
+    BIOS date and model byte directly from the BIOS area, takes the boot drive from the Disk struct, checksums the
+    SMBIOS entry point (and table), and asks the BIOS how much memory there is with int 12h and int 15h, ax e801h.
+
+*/
+
+void GetProbeKey(ProbeKeyStruct* Key, uint8 Memtest, uint32 Smbios) {
+
+  Memset((void*)Key, 0, sizeof(ProbeKeyStruct));
+
+  Memcpy((void*)Key->BiosDate, (void*)0xFFFF5, 8);
+  Key->BiosModel = *(volatile uint8*)0xFFFFE;
+  Key->Memtest = Memtest;
+  Key->Drive = Disk.Drive;
+
+  // SMBIOS 3.0+ entry points have a 64-bit table address at 10h, while older ones have a 32-bit address at 18h, and
+  // a 16-bit table length at 16h. We only look at the table if it's under 4GiB.
+
+  if (Smbios != 0) {
+
+    uint32 TableAddress;
+    uint32 TableLength;
+
+    if (*(volatile uint8*)(Smbios + 3) == '3') {
+
+      Key->SmbiosEntryChecksum = Checksum((void*)Smbios, *(volatile uint8*)(Smbios + 0x06));
+      TableAddress = (*(volatile uint32*)(Smbios + 0x14) == 0) ? *(volatile uint32*)(Smbios + 0x10) : 0;
+      TableLength = *(volatile uint32*)(Smbios + 0x0C);
+
+    } else {
+
+      Key->SmbiosEntryChecksum = Checksum((void*)Smbios, *(volatile uint8*)(Smbios + 0x05));
+      TableAddress = *(volatile uint32*)(Smbios + 0x18);
+      TableLength = *(volatile uint16*)(Smbios + 0x16);
+
+    }
+
+    if (TableLength > 4096) TableLength = 4096;
+
+    if (TableAddress != 0) {
+
+      Key->SmbiosTableChecksum = Checksum((void*)TableAddress, TableLength);
+
+    }
+
+  }
+
+  Key->LowMemory = GetLowMemorySize();
+  Key->ExtendedMemory = GetExtendedMemorySize();
+
+}
+
+
+
+/*  LoadProbeCache(): Loads the probe cache from disk, if it's valid for the current system.
+
+    Input:        ProbeKeyStruct* Key                - The key of the current system, from GetProbeKey().
+
+    Output:       BootTableType* BootTable           - If the cache is valid, the cached memory map (and the number
+                                                     of its last entry) and EDD parameters are copied here.
+
+    Output:       bool                               - This returns true if the cache was valid and was loaded, and
+                                                     false if it wasn't (in which case, nothing is written).
+
+    This function reads the probe cache from the storage sectors in Boot.bin into the disk buffer, and checks that it
+    has the right signature, version and size, that its checksum is valid, and that it was made on the same system
+    (with the same key). If all of that matches, then the data in it can be used instead of probing the hardware.
+
+*/
+
+bool LoadProbeCache(ProbeKeyStruct* Key, BootTableType* BootTable) {
+
+  ProbeCacheStruct* Cache = (ProbeCacheStruct*)DiskBuffer;
+  uint32 Sectors = (sizeof(ProbeCacheStruct) + 511) / 512;
+
+  if (ReadSectors(CacheSector, Sectors, DiskBuffer) != true) {
+
+    return false;
+
+  }
+
+  // Check the signature, the version and the size.
+
+  if ((Cache->Signature != CacheSignature) || (Cache->Version != CacheVersion)) return false;
+  if (Cache->MemoryMapLastEntry >= 128) return false;
+
+  uint32 UnusedEntries = 127 - Cache->MemoryMapLastEntry;
+  if (Cache->Size != (sizeof(ProbeCacheStruct) - (UnusedEntries * sizeof(MemoryMapEntryStruct)))) return false;
+
+  // Check the checksum, and then the key.
+
+  uint32 CacheChecksum = Cache->Checksum;
+  Cache->Checksum = 0;
+
+  if (Checksum((void*)Cache, Cache->Size) != CacheChecksum) return false;
+  if (Memcmp((void*)&Cache->Key, (void*)Key, sizeof(ProbeKeyStruct)) != 0) return false;
+
+  // Everything matches, so copy the data over.
+
+  uint32 LastEntry = Cache->MemoryMapLastEntry;
+
+  BootTable->MemoryMapLastEntry = LastEntry;
+  Memcpy((void*)BootTable->MemoryMap, (void*)Cache->MemoryMap, (LastEntry + 1) * sizeof(MemoryMapEntryStruct));
+  Memcpy((void*)&BootTable->Edd, (void*)&Cache->Edd, sizeof(EddStruct));
+
+  return true;
+
+}
+
+
+
+/*  StoreProbeCache(): Stores a snapshot of the current hardware data in the probe cache.
+
+    Input:        ProbeKeyStruct* Key                - The key of the current system, from GetProbeKey().
+
+    Input:        BootTableType* BootTable           - The BootTable with the memory map (and the number of its last
+                                                     entry) and EDD parameters you want to store.
+
+    Output:       bool                               - This returns true if the cache was written to disk, and false if
+                                                     it wasn't (for example, if the boot medium is read-only).
+
+    This function builds a new probe cache in the disk buffer, and writes it to the storage sectors in Boot.bin, so
+    that the next boot can use it instead of probing the hardware again. As this only runs when the cache is out of
+    date, it's in the Probe overlay, which is loaded the first time this is called (see OverlayEntry()).
+
+*/
+
+OverlayEntry(Probe, StoreProbeCache);
+
+bool Overlay(Probe) StoreProbeCache(ProbeKeyStruct* Key, BootTableType* BootTable) {
+
+  ProbeCacheStruct* Cache = (ProbeCacheStruct*)DiskBuffer;
+  uint32 Sectors = (sizeof(ProbeCacheStruct) + 511) / 512;
+  uint32 LastEntry = BootTable->MemoryMapLastEntry;
+
+  Memset((void*)Cache, 0, (Sectors * 512));
+
+  Cache->Signature = CacheSignature;
+  Cache->Version = CacheVersion;
+  Cache->Size = sizeof(ProbeCacheStruct) - ((127 - LastEntry) * sizeof(MemoryMapEntryStruct));
+
+  Memcpy((void*)&Cache->Key, (void*)Key, sizeof(ProbeKeyStruct));
+
+  Memcpy((void*)&Cache->Edd, (void*)&BootTable->Edd, sizeof(EddStruct));
+
+  Cache->MemoryMapLastEntry = LastEntry;
+  Memcpy((void*)Cache->MemoryMap, (void*)BootTable->MemoryMap, (LastEntry + 1) * sizeof(MemoryMapEntryStruct));
+
+  Cache->Checksum = Checksum((void*)Cache, Cache->Size);
+
+  return WriteSectors(CacheSector, Sectors, DiskBuffer);
+
+}
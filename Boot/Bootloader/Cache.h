@@ -0,0 +1,53 @@
+/* Ribeira | Written in 2022 by NunoLealF
+   To the extent possible under law, NunoLealF has waived all copyright and related or neighboring rights to this
+   software to the public domain worldwide. This software is distributed without any warranty.
+
+   You should have received a copy of the CC0 Public Domain Dedication along with this software.
+   If not, see <http://creativecommons.org/publicdomain/zero/1.0/>. */
+
+// WARNING: This is 16-bit C code. You should compile this, along with any other files from the second stage
+// bootloader, with the -m16 (or equivalent) flag.
+
+#ifndef _CACHE_H_
+#define _CACHE_H_
+
+// The probe cache lives in the last 16 sectors of Boot.bin (LBA 48 to 63), which the makefile reserves for storage.
+
+#define CacheSector     48
+#define CacheSectors    16
+#define CacheSignature  0x43504252
+#define CacheVersion    2
+
+typedef volatile struct _ProbeKeyStruct_ {
+
+  uint8                   BiosDate[8];
+  uint8                   BiosModel;
+  uint8                   Memtest;
+  uint8                   Drive;
+  uint8                   Reserved;
+  uint32                  SmbiosEntryChecksum;
+  uint32                  SmbiosTableChecksum;
+  uint32                  LowMemory;
+  uint32                  ExtendedMemory;
+
+} __attribute__((packed)) ProbeKeyStruct;
+
+typedef volatile struct _ProbeCacheStruct_ {
+
+  uint32                  Signature;
+  uint16                  Version;
+  uint16                  Size;
+  uint32                  Checksum;
+  ProbeKeyStruct          Key;
+  EddStruct               Edd;
+  uint32                  MemoryMapLastEntry;
+  MemoryMapEntryStruct    MemoryMap[128];
+
+} __attribute__((packed)) ProbeCacheStruct;
+
+void GetProbeKey(ProbeKeyStruct* Key, uint8 Memtest, uint32 Smbios);
+
+bool LoadProbeCache(ProbeKeyStruct* Key, BootTableType* BootTable);
+bool StoreProbeCache(ProbeKeyStruct* Key, BootTableType* BootTable);
+
+#endif
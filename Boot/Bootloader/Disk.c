@@ -0,0 +1,322 @@
+/* Ribeira | Written in 2022 by NunoLealF
+   To the extent possible under law, NunoLealF has waived all copyright and related or neighboring rights to this
+   software to the public domain worldwide. This software is distributed without any warranty.
+
+   You should have received a copy of the CC0 Public Domain Dedication along with this software.
+   If not, see <http://creativecommons.org/publicdomain/zero/1.0/>. */
+
+// WARNING: This is 16-bit C code. You should compile this, along with any other files from the second stage
+// bootloader, with the -m16 (or equivalent) flag.
+
+#include "Stdint.h"
+#include "Memory.h"
+#include "Disk.h"
+
+/*  DiskStruct: This is a struct that contains the information we need to access the disk we booted from.
+
+    uint8 Drive                                      - The BIOS drive number of the disk, as given to the bootsector
+                                                     by the BIOS in DL.
+
+    bool Extensions                                  - Whether the BIOS supports the int 13h extensions for this drive,
+                                                     which let us use LBA addressing instead of CHS.
+
+    uint16 SectorsPerTrack, Heads                    - The geometry of the disk, as given by int 13h, ah 08h. This is
+                                                     only used when the int 13h extensions aren't supported.
+
+*/
+
+DiskStruct Disk;
+
+
+
+/*  DiskAddressPacketStruct: This is the struct that the int 13h extensions (ah 42h and 43h) take in DS:SI.
+
+    uint8 Size                                       - The size of the packet, which is always 10h.
+
+    uint8 Reserved                                   - This is reserved, and must be zero.
+
+    uint16 Sectors                                   - The amount of sectors to transfer. Some BIOSes can't handle
+                                                     more than 127 sectors at a time.
+
+    uint16 Offset, Segment                           - The segment:offset address of the buffer to transfer to/from.
+
+    uint32 LowLba, HighLba                           - The LBA of the first sector to transfer, split into two.
+
+*/
+
+typedef volatile struct _DiskAddressPacketStruct_ {
+
+  uint8                   Size;
+  uint8                   Reserved;
+  uint16                  Sectors;
+  uint16                  Offset;
+  uint16                  Segment;
+  uint32                  LowLba;
+  uint32                  HighLba;
+
+} __attribute__((packed)) DiskAddressPacketStruct;
+
+
+
+/*  InitializeDisk(): Initializes the Disk struct for the disk we booted from.
+
+    Input:        uint8 Drive                        - The BIOS drive number of the disk you want to use.
+
+    This function fills out the Disk struct, which the other functions in this file rely on. It checks whether the
+    int 13h extensions are supported with int 13h, ah 41h, and gets the geometry of the disk with int 13h, ah 08h.
+
+    If the BIOS doesn't give us a geometry (which can happen with some emulated drives), then we assume the usual
+    63 sectors per track and 255 heads.
+
+*/
+
+void InitializeDisk(uint8 Drive) {
+
+  Disk.Drive = Drive;
+  Disk.Extensions = false;
+  Disk.SectorsPerTrack = 63;
+  Disk.Heads = 255;
+
+  // Check for the int 13h extensions.
+
+  uint32 Function = 0x4100;
+  uint32 Signature = 0x55AA;
+  uint32 Support = 0;
+  uint32 Dx = Drive;
+  uint8 Carry = 1;
+
+  __asm__ volatile( "int $0x13; setc %0" :
+                    "=qm" (Carry), "+a" (Function), "+b" (Signature), "=c" (Support), "+d" (Dx) :
+                    :
+                    "cc", "memory");
+
+  if ((Carry == 0) && ((Signature & 0xFFFF) == 0xAA55) && ((Support & 1) != 0)) {
+
+    Disk.Extensions = true;
+
+  }
+
+  // Get the geometry of the disk. This call also changes ES:DI, so we save ES.
+
+  uint32 Geometry = 0;
+  uint32 Heads = Drive;
+  uint32 Table = 0;
+
+  Function = 0x0800;
+
+  __asm__ volatile( "pushw %%es; int $0x13; setc %0; popw %%es" :
+                    "=qm" (Carry), "+a" (Function), "=c" (Geometry), "+d" (Heads), "+D" (Table) :
+                    :
+                    "ebx", "cc", "memory");
+
+  if ((Carry == 0) && ((Geometry & 0x3F) != 0)) {
+
+    Disk.SectorsPerTrack = (Geometry & 0x3F);
+    Disk.Heads = ((Heads >> 8) & 0xFF) + 1;
+
+  }
+
+}
+
+
+
+/*  TransferSectors(): Reads or writes a number of sectors from/to the disk, in one BIOS call.
+
+    Input:        uint8 Function                     - 02h to read, or 03h to write.
+
+    Input:        uint32 Lba                         - The LBA of the first sector.
+
+    Input:        uint16 Count                       - The amount of sectors to transfer. This must fit in one call,
+                                                     so it can't cross a track (if using CHS) or a 64KiB boundary.
+
+    Input:        uint32 Buffer                      - The linear address of the buffer; this must be under 1MiB.
+
+    Output:       bool                               - This returns true if the transfer worked, and false if it didn't.
+
+    This function transfers Count sectors between the disk and a buffer in memory, with int 13h, ah 42h/43h if the
+    extensions are available, or int 13h ah 02h/03h otherwise. It tries up to three times, resetting the disk
+    (with int 13h, ah 00h) after each failure, as floppy drives in particular tend to fail the first time.
+    As this is a static function, it is not accessible outside of this file.
+
+*/
+
+static bool TransferSectors(uint8 Function, uint32 Lba, uint16 Count, uint32 Buffer) {
+
+  uint16 Segment = (Buffer >> 4);
+  uint16 Offset = (Buffer & 0x0F);
+
+  for (int Attempt = 0; Attempt < 3; Attempt++) {
+
+    uint8 Carry = 1;
+
+    if (Disk.Extensions == true) {
+
+      DiskAddressPacketStruct Packet = {0x10, 0, Count, Offset, Segment, Lba, 0};
+      uint32 Ax = ((uint32)(Function + 0x40) << 8);
+
+      __asm__ volatile( "int $0x13; setc %0" :
+                        "=qm" (Carry), "+a" (Ax) :
+                        "d"   (Disk.Drive), "S" (&Packet) :
+                        "cc", "memory");
+
+    } else {
+
+      uint32 Sector   = (Lba % Disk.SectorsPerTrack) + 1;
+      uint32 Head     = (Lba / Disk.SectorsPerTrack) % Disk.Heads;
+      uint32 Cylinder = (Lba / Disk.SectorsPerTrack) / Disk.Heads;
+
+      uint32 Ax = ((uint32)Function << 8) | Count;
+      uint32 Cx = ((Cylinder & 0xFF) << 8) | ((Cylinder >> 2) & 0xC0) | Sector;
+      uint32 Dx = (Head << 8) | Disk.Drive;
+
+      __asm__ volatile( "pushw %%es; movw %%si, %%es; int $0x13; setc %0; popw %%es" :
+                        "=qm" (Carry), "+a" (Ax) :
+                        "b"   (Offset), "c" (Cx), "d" (Dx), "S" (Segment) :
+                        "cc", "memory");
+
+    }
+
+    if (Carry == 0) {
+
+      return true;
+
+    }
+
+    uint32 Reset = 0;
+    __asm__ volatile("int $0x13" : "+a" (Reset) : "d" (Disk.Drive) : "cc");
+
+  }
+
+  return false;
+
+}
+
+
+
+/*  SplitTransfer(): Reads or writes any number of sectors from/to the disk.
+
+    Input:        uint8 Function                     - 02h to read, or 03h to write.
+
+    Input:        uint32 Lba, Count, Buffer          - (Same as TransferSectors, although there's no limit on Count)
+
+    Output:       bool                               - This returns true if the transfer worked, and false if it didn't.
+
+    This function splits up a transfer into as few BIOS calls as possible. Each call transfers at most 127 sectors,
+    and never crosses a 64KiB boundary in memory (which the DMA controller can't handle on some machines), or the end
+    of a track when using CHS. The buffer should be aligned to 512 bytes.
+    As this is a static function, it is not accessible outside of this file.
+
+*/
+
+static bool SplitTransfer(uint8 Function, uint32 Lba, uint32 Count, uint32 Buffer) {
+
+  while (Count > 0) {
+
+    uint32 Chunk = (Count > 127) ? 127 : Count;
+    uint32 Boundary = (0x10000 - (Buffer & 0xFFFF)) / 512;
+
+    if ((Boundary != 0) && (Chunk > Boundary)) Chunk = Boundary;
+
+    if (Disk.Extensions != true) {
+
+      uint32 TrackLeft = Disk.SectorsPerTrack - (Lba % Disk.SectorsPerTrack);
+      if (Chunk > TrackLeft) Chunk = TrackLeft;
+
+    }
+
+    if (TransferSectors(Function, Lba, Chunk, Buffer) != true) {
+
+      return false;
+
+    }
+
+    Lba += Chunk;
+    Count -= Chunk;
+    Buffer += (Chunk * 512);
+
+  }
+
+  return true;
+
+}
+
+
+
+/*  ReadSectors(): Reads a number of sectors from the disk we booted from.
+
+    Input:        uint32 Lba                         - The LBA of the first sector you want to read. LBA 0 is the
+                                                     bootsector.
+
+    Input:        uint32 Count                       - The amount of sectors you want to read.
+
+    Input:        uint32 Buffer                      - The linear address you want to read the sectors into. This must
+                                                     be under 1MiB, and should be aligned to 512 bytes.
+
+    Output:       bool                               - This returns true if the read worked, and false if it didn't.
+
+    This function reads Count sectors from the disk we booted from (in the Disk struct), into the buffer at Buffer.
+
+*/
+
+bool ReadSectors(uint32 Lba, uint32 Count, uint32 Buffer) {
+
+  return SplitTransfer(0x02, Lba, Count, Buffer);
+
+}
+
+
+
+/*  WriteSectors(): Writes a number of sectors to the disk we booted from.
+
+    Input:        uint32 Lba, Count, Buffer          - (Same as ReadSectors)
+
+    Output:       bool                               - This returns true if the write worked, and false if it didn't.
+
+    This function writes Count sectors from the buffer at Buffer to the disk we booted from. Keep in mind that this
+    can fail on read-only media (like a CD), so you shouldn't rely on it working.
+
+*/
+
+bool WriteSectors(uint32 Lba, uint32 Count, uint32 Buffer) {
+
+  return SplitTransfer(0x03, Lba, Count, Buffer);
+
+}
+
+
+
+/*  GetDriveParameters(): Gets the extended parameters of the disk we booted from.
+
+    Output:       uint32 Buffer                      - The linear address of the buffer you want the parameters to be
+                                                     written to. This must be under 64KiB, as it's given in DS:SI.
+
+    Input:        uint16 Size                        - The size of that buffer, in bytes (at least 1Ah).
+
+    Output:       bool                               - This returns true if the BIOS filled out the buffer, and false if
+                                                     it didn't (or if the int 13h extensions aren't supported).
+
+    This function calls int 13h, ah 48h (from the EDD specification), which gives us the size of the disk in sectors,
+    the size of each sector and, on EDD 3.0+, which interface and device path the disk is on. The first word of the
+    buffer is set to its size beforehand, and is changed by the BIOS to the amount of bytes it actually wrote.
+
+*/
+
+bool GetDriveParameters(uint32 Buffer, uint16 Size) {
+
+  if ((Disk.Extensions != true) || (Size < 0x1A)) return false;
+
+  Memset((void*)Buffer, 0, Size);
+  *(volatile uint16*)Buffer = Size;
+
+  uint32 Function = 0x4800;
+  uint32 Dx = Disk.Drive;
+  uint8 Carry = 1;
+
+  __asm__ volatile( "int $0x13; setc %0" :
+                    "=qm" (Carry), "+a" (Function), "+d" (Dx) :
+                    "S" (Buffer) :
+                    "cc", "memory");
+
+  return ((Carry == 0) && ((Function & 0xFF00) == 0)) ? true : false;
+
+}
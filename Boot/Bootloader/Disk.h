@@ -0,0 +1,40 @@
+/* Ribeira | Written in 2022 by NunoLealF
+   To the extent possible under law, NunoLealF has waived all copyright and related or neighboring rights to this
+   software to the public domain worldwide. This software is distributed without any warranty.
+
+   You should have received a copy of the CC0 Public Domain Dedication along with this software.
+   If not, see <http://creativecommons.org/publicdomain/zero/1.0/>. */
+
+// WARNING: This is 16-bit C code. You should compile this, along with any other files from the second stage
+// bootloader, with the -m16 (or equivalent) flag.
+
+#ifndef _DISK_H_
+#define _DISK_H_
+
+// The bootsector stores the drive number it was booted from at 7C40h, which is the drive number field of the
+// (FAT32) BPB. The disk buffer is an 8KiB area under 64KiB in memory that's used for any disk transfers, since the
+// BIOS can only read into memory under 1MiB. It's just large enough for the whole probe cache (16 sectors).
+
+#define BootDriveLocation  0x7C40
+#define DiskBuffer         0x1000
+#define DiskBufferSize     0x2000
+
+typedef struct _DiskStruct_ {
+
+  uint8                   Drive;
+  bool                    Extensions;
+  uint16                  SectorsPerTrack;
+  uint16                  Heads;
+
+} DiskStruct;
+
+extern DiskStruct Disk;
+
+void InitializeDisk(uint8 Drive);
+
+bool ReadSectors(uint32 Lba, uint32 Count, uint32 Buffer);
+bool WriteSectors(uint32 Lba, uint32 Count, uint32 Buffer);
+
+bool GetDriveParameters(uint32 Buffer, uint16 Size);
+
+#endif
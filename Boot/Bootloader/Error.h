@@ -21,6 +21,9 @@ const char* ErrorMessage[] = {
   "int 15h, ax e820h. This may happen if your machine is very old. \n\r" // 2
   "Make sure that your system meets the minimum requirements.", // 2
 
+  "Failed to load part of the second-stage bootloader (an overlay) from the \n\r" // 3
+  "disk. Try rebooting the system.", // 3
+
 };
 
 #endif
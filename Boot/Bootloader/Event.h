@@ -0,0 +1,58 @@
+/* Ribeira | Written in 2022 by NunoLealF
+   To the extent possible under law, NunoLealF has waived all copyright and related or neighboring rights to this
+   software to the public domain worldwide. This software is distributed without any warranty.
+
+   You should have received a copy of the CC0 Public Domain Dedication along with this software.
+   If not, see <http://creativecommons.org/publicdomain/zero/1.0/>. */
+
+// WARNING: This is 16-bit C code. You should compile this, along with any other files from the second stage
+// bootloader, with the -m16 (or equivalent) flag.
+
+#ifndef _EVENT_H_
+#define _EVENT_H_
+
+#define EventMessageSize  80
+
+// These are the messages for every event in the boot log (see Log.h), in the same order. When they're shown,
+// %0 to %3 are replaced with the arguments of the event in decimal, and #0 to #3 with the arguments in hex. They're
+// only needed by RenderLog(), so they're kept in the Log overlay (which is why every message has a fixed size).
+
+const char EventMessage[][EventMessageSize] OverlayData(Log) = {
+
+  "Started the second-stage bootloader.", // 0
+
+  "Booting from drive #0h.", // 1
+
+  "Using the cached system memory map (%0 entries).", // 2
+
+  "Got the system memory map from E820 (%0 entries).", // 3
+
+  "Tested %0 MiB of memory at %1 MB/s, found %2 bad range(s).", // 4
+
+  "Skipped the memory test, as the A20 line is disabled.", // 5
+
+  "Got the EDD parameters of drive #0h (%1 bytes).", // 6
+
+  "Stored the hardware data in the probe cache.", // 7
+
+  "Couldn't store the hardware data in the probe cache.", // 8
+
+  "Found the ACPI RSDP at #0h (revision %1).", // 9
+
+  "Found the SMBIOS entry point at #0h.", // 10
+
+  "Loaded module %2 of the boot entry at #0h (%1 bytes).", // 11
+
+  "Couldn't load module %0 of the boot entry from the module archive.", // 12
+
+  "Couldn't find a valid module archive.", // 13
+
+  "Booting entry %0; %1 of its %2 module(s) were read in the background.", // 14
+
+  "Switched to unreal mode, with the A20 line enabled.", // 15
+
+  "Couldn't enable the A20 line, so no modules can be loaded above 1MiB.", // 16
+
+};
+
+#endif
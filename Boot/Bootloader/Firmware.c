@@ -0,0 +1,307 @@
+/* Ribeira | Written in 2022 by NunoLealF
+   To the extent possible under law, NunoLealF has waived all copyright and related or neighboring rights to this
+   software to the public domain worldwide. This software is distributed without any warranty.
+
+   You should have received a copy of the CC0 Public Domain Dedication along with this software.
+   If not, see <http://creativecommons.org/publicdomain/zero/1.0/>. */
+
+// WARNING: This is 16-bit C code. You should compile this, along with any other files from the second stage
+// bootloader, with the -m16 (or equivalent) flag.
+
+#include "Stdint.h"
+#include "Memory.h"
+#include "Archive.h"
+#include "Log.h"
+#include "BootTable.h"
+#include "Firmware.h"
+
+/*  FindSignature(): Scans an area of memory for a signature, on 16-byte boundaries.
+
+    Input:        uint32 Start, End                  - The (linear) start and end addresses of the area you want to
+                                                     scan. Start should be aligned to 16 bytes.
+
+    Input:        const char* Signature              - The signature you're looking for, like "_SM_".
+
+    Input:        uint8 Length                       - The length of the signature, in bytes.
+
+    Output:       uint32                             - The address where the signature was found, or 0 if it wasn't.
+
+    This function looks for a signature in an area of memory, only checking every 16 bytes, since that's how every
+    firmware table we care about (the ACPI RSDP and the SMBIOS entry points) is aligned. Only the first byte is
+    compared until it matches, so this is quite fast, even over the whole BIOS area (E0000h to FFFFFh).
+
+*/
+
+uint32 FindSignature(uint32 Start, uint32 End, const char* Signature, uint8 Length) {
+
+  for (uint32 Address = Start; (Address + Length) <= End; Address += 16) {
+
+    volatile uint8* Table = (volatile uint8*)Address;
+
+    if (Table[0] != (uint8)Signature[0]) continue;
+
+    uint8 i = 1;
+    while ((i < Length) && (Table[i] == (uint8)Signature[i])) i++;
+
+    if (i == Length) {
+
+      return Address;
+
+    }
+
+  }
+
+  return 0;
+
+}
+
+
+
+/*  ValidChecksum(): Checks if a firmware table has a valid (8-bit) checksum.
+
+    Input:        uint32 Address                     - The (linear) address of the table.
+
+    Input:        uint32 Length                      - The length of the table, in bytes.
+
+    Output:       bool                               - This returns true if every byte of the table adds up to zero
+                                                     (ignoring overflow), and false if it doesn't, or if the length is
+                                                     zero.
+
+    Pretty much every table the firmware gives us (ACPI, SMBIOS, etc.) has a checksum byte, which is set so that every
+    byte in the table adds up to zero. This function checks that, which is the only way to tell a real table from
+    some random bytes that happen to look like a signature. A table with no bytes at all would always pass, so that
+    doesn't count as valid; callers should also check that the length is at least the size of the table's header.
+
+*/
+
+bool ValidChecksum(uint32 Address, uint32 Length) {
+
+  if (Length == 0) return false;
+
+  uint8 Sum = 0;
+
+  for (uint32 i = 0; i < Length; i++) {
+
+    Sum += *(volatile uint8*)(Address + i);
+
+  }
+
+  return (Sum == 0) ? true : false;
+
+}
+
+
+
+/*  FindEntryPoint(): Finds a firmware entry point with a length byte and a checksum, in the BIOS area.
+
+    Input:        const char* Signature              - The signature of the entry point, like "_SM_".
+
+    Input:        uint8 Length                       - The length of the signature, in bytes.
+
+    Input:        uint8 LengthOffset                 - The offset of the entry point's length byte.
+
+    Input:        uint8 MinimumLength                - The smallest length a valid entry point can have.
+
+    Output:       uint32                             - The address of the first valid entry point, or 0 if there isn't
+                                                     one.
+
+    This function goes through every match of the signature in the BIOS area (F0000h to FFFFFh), and returns the
+    first one whose length is sensible and whose checksum is valid, so a stray copy of the signature (for example, in
+    the BIOS code itself) doesn't hide the real entry point after it.
+    As this is a static function, it is not accessible outside of this file.
+
+*/
+
+static uint32 FindEntryPoint(const char* Signature, uint8 Length, uint8 LengthOffset, uint8 MinimumLength) {
+
+  for (uint32 Address = 0xF0000; Address < 0x100000; Address += 16) {
+
+    Address = FindSignature(Address, 0x100000, Signature, Length);
+
+    if (Address == 0) break;
+
+    uint8 EntryLength = *(volatile uint8*)(Address + LengthOffset);
+
+    if ((EntryLength >= MinimumLength) && (ValidChecksum(Address, EntryLength) == true)) {
+
+      return Address;
+
+    }
+
+  }
+
+  return 0;
+
+}
+
+
+
+/*  FindSmbiosEntryPoint(): Finds the SMBIOS entry point.
+
+    Output:       uint32                             - The address of the SMBIOS entry point, or 0 if there isn't one.
+
+    This function looks for the SMBIOS entry point in the BIOS area (F0000h to FFFFFh). The 64-bit (SMBIOS 3.0+) entry
+    point has the signature "_SM3_" and its length at offset 06h (at least 18h bytes), and the 32-bit entry point has
+    the signature "_SM_" and its length at offset 05h (at least 1Eh bytes, since some SMBIOS 2.1 systems report 1Eh
+    instead of 1Fh). We prefer the former, but we accept either, as long as its checksum is valid.
+
+    This scans the whole BIOS area, so it should only be called once; GetProbeKey() and GetSmbios() both take the
+    address it returns.
+
+*/
+
+uint32 FindSmbiosEntryPoint(void) {
+
+  uint32 Address = FindEntryPoint("_SM3_", 5, 0x06, 0x18);
+
+  if (Address == 0) {
+
+    Address = FindEntryPoint("_SM_", 4, 0x05, 0x1E);
+
+  }
+
+  return Address;
+
+}
+
+
+
+/*  ValidRsdp(): Checks if there's a valid ACPI RSDP at an address.
+
+    Input:        uint32 Address                     - The (linear) address of the possible RSDP.
+
+    Output:       bool                               - This returns true if it's a valid RSDP, and false if it isn't.
+
+    The first 20 bytes of the RSDP (which is all that ACPI 1.0 has) have their own checksum. On ACPI 2.0+ (revision
+    2 or above), the RSDP also has a length at offset 14h, and an extended checksum that covers all of it.
+    As this is a static function, it is not accessible outside of this file.
+
+*/
+
+static bool ValidRsdp(uint32 Address) {
+
+  if (ValidChecksum(Address, 20) != true) return false;
+  if (*(volatile uint8*)(Address + 0x0F) < 2) return true;
+
+  uint32 Length = *(volatile uint32*)(Address + 0x14);
+
+  if ((Length < 36) || (Length > 4096)) return false;
+  return ValidChecksum(Address, Length);
+
+}
+
+
+
+/*  FindRsdp(): Finds the ACPI RSDP (Root System Description Pointer).
+
+    Output:       uint32                             - The address of the RSDP, or 0 if there isn't one.
+
+    This function looks for the signature "RSD PTR " in the two places the ACPI specification allows it to be; the
+    first 1KiB of the EBDA (whose segment is at 40Eh in the BIOS data area), and the BIOS area (E0000h to FFFFFh).
+    Every match has its checksum checked, so that a stray signature in the BIOS code isn't mistaken for the RSDP.
+
+*/
+
+uint32 FindRsdp(void) {
+
+  uint32 Areas[2][2] = {{0, 0}, {0xE0000, 0x100000}};
+
+  Areas[0][0] = (uint32)(*(volatile uint16*)0x40E) << 4;
+  Areas[0][1] = Areas[0][0] + 1024;
+
+  for (int i = 0; i < 2; i++) {
+
+    // Skip the EBDA if the BIOS data area doesn't point to a sensible one.
+
+    if ((Areas[i][0] < 0x500) || (Areas[i][1] > 0x100000)) continue;
+
+    for (uint32 Address = Areas[i][0]; Address < Areas[i][1]; Address += 16) {
+
+      Address = FindSignature(Address, Areas[i][1], "RSD PTR ", 8);
+
+      if (Address == 0) {
+
+        break;
+
+      } else if (ValidRsdp(Address) == true) {
+
+        return Address;
+
+      }
+
+    }
+
+  }
+
+  return 0;
+
+}
+
+
+
+/*  GetRsdp(): Finds the ACPI RSDP, and makes a copy of it.
+
+    Output:       RsdpStruct* Rsdp                   - The struct you want to copy the RSDP (and its address) to.
+
+    Output:       bool                               - This returns true if there's an RSDP, and false if there isn't
+                                                     (in which case, nothing is written).
+
+    This function copies the RSDP (20 bytes on ACPI 1.0, or up to 36 bytes on ACPI 2.0+) into Rsdp, so that the kernel
+    can get the address of the RSDT or XSDT without having to scan for it again.
+
+*/
+
+bool GetRsdp(RsdpStruct* Rsdp) {
+
+  uint32 Address = FindRsdp();
+
+  if (Address == 0) return false;
+
+  uint32 Length = 20;
+
+  if (*(volatile uint8*)(Address + 0x0F) >= 2) {
+
+    Length = *(volatile uint32*)(Address + 0x14);
+    if (Length > sizeof(Rsdp->Table)) Length = sizeof(Rsdp->Table);
+
+  }
+
+  Rsdp->Address = Address;
+  Rsdp->Length = Length;
+  Memcpy((void*)Rsdp->Table, (void*)Address, Length);
+
+  return true;
+
+}
+
+
+
+/*  GetSmbios(): Makes a copy of the SMBIOS entry point.
+
+    Output:       SmbiosStruct* Smbios               - The struct you want to copy the entry point (and its address) to.
+
+    Input:        uint32 Address                     - The address of the SMBIOS entry point, from
+                                                     FindSmbiosEntryPoint(), or 0 if there isn't one.
+
+    Output:       bool                               - This returns true if there's an SMBIOS entry point, and false if
+                                                     there isn't (in which case, nothing is written).
+
+    This function copies the SMBIOS entry point (which is 18h bytes long for the 64-bit one, and 1Fh bytes long for
+    the 32-bit one) into Smbios. The kernel can then tell which one it is from the signature at the start.
+
+*/
+
+bool GetSmbios(SmbiosStruct* Smbios, uint32 Address) {
+
+  if (Address == 0) return false;
+
+  uint32 Length = *(volatile uint8*)(Address + ((*(volatile uint8*)(Address + 3) == '3') ? 0x06 : 0x05));
+  if (Length > sizeof(Smbios->Table)) Length = sizeof(Smbios->Table);
+
+  Smbios->Address = Address;
+  Smbios->Length = Length;
+  Memcpy((void*)Smbios->Table, (void*)Address, Length);
+
+  return true;
+
+}
@@ -0,0 +1,23 @@
+/* Ribeira | Written in 2022 by NunoLealF
+   To the extent possible under law, NunoLealF has waived all copyright and related or neighboring rights to this
+   software to the public domain worldwide. This software is distributed without any warranty.
+
+   You should have received a copy of the CC0 Public Domain Dedication along with this software.
+   If not, see <http://creativecommons.org/publicdomain/zero/1.0/>. */
+
+// WARNING: This is 16-bit C code. You should compile this, along with any other files from the second stage
+// bootloader, with the -m16 (or equivalent) flag.
+
+#ifndef _FIRMWARE_H_
+#define _FIRMWARE_H_
+
+uint32 FindSignature(uint32 Start, uint32 End, const char* Signature, uint8 Length);
+bool ValidChecksum(uint32 Address, uint32 Length);
+
+uint32 FindSmbiosEntryPoint(void);
+uint32 FindRsdp(void);
+
+bool GetRsdp(RsdpStruct* Rsdp);
+bool GetSmbios(SmbiosStruct* Smbios, uint32 Address);
+
+#endif
@@ -176,13 +176,15 @@ void Putchar(const char Character, uint8 Color) {
 
     case '\n':
 
+      Terminal.Y++;
+
       if (Terminal.Y >= Terminal.Max_Y) {
 
         Scroll();
+        Terminal.Y = Terminal.Max_Y - 1;
 
       }
 
-      Terminal.Y++;
       break;
 
 
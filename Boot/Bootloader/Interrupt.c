@@ -0,0 +1,233 @@
+/* Ribeira | Written in 2022 by NunoLealF
+   To the extent possible under law, NunoLealF has waived all copyright and related or neighboring rights to this
+   software to the public domain worldwide. This software is distributed without any warranty.
+
+   You should have received a copy of the CC0 Public Domain Dedication along with this software.
+   If not, see <http://creativecommons.org/publicdomain/zero/1.0/>. */
+
+// WARNING: This is 16-bit C code. You should compile this, along with any other files from the second stage
+// bootloader, with the -m16 (or equivalent) flag.
+
+#include "Stdint.h"
+#include "Interrupt.h"
+#include "Overlay.h"
+
+/*  TimerTicks: The amount of times the PIT has fired (IRQ 0) since InstallInterrupts() was called. The BIOS leaves
+    the PIT at its default rate, which is about 18.2 times a second (TicksPerTenSeconds times every ten seconds).
+
+    KeyboardBuffer, KeyboardHead, KeyboardTail: A ring buffer of the scancodes from the PS/2 keyboard (IRQ 1). The
+    interrupt handler adds scancodes at KeyboardHead, and GetScancode() takes them out at KeyboardTail. If the buffer
+    is full, new scancodes are dropped.
+
+    OldTimerVector, OldKeyboardVector: The original (BIOS) handlers for int 08h and int 09h, as segment:offset pairs
+    (in the same format as the IVT), so that they can be chained to, and restored later on.
+
+    Every one of these is accessed from the interrupt handlers below, which only rely on CS (which is always 0), so
+    they work no matter what the rest of the registers are set to when an interrupt fires.
+
+    The handlers and RestoreInterrupts() stay in the core, since Crash() has to be able to unhook them at any time
+    (even after another overlay has been loaded over the boot menu). Everything else is only used by the boot menu,
+    so it's in the Menu overlay.
+
+*/
+
+volatile uint32 TimerTicks;
+volatile uint8 KeyboardBuffer[KeyboardBufferSize];
+volatile uint8 KeyboardHead;
+volatile uint8 KeyboardTail;
+
+volatile uint32 OldTimerVector;
+volatile uint32 OldKeyboardVector;
+
+static bool Installed = false;
+
+
+
+/*  TimerHandler: The interrupt handler for int 08h (IRQ 0, the PIT).
+
+    This handler counts the tick, and then jumps to the BIOS's own handler, which updates the BIOS tick count (at
+    46Ch), takes care of things like turning off the floppy motor, and sends the EOI to the PIC for us.
+
+    KeyboardHandler: The interrupt handler for int 09h (IRQ 1, the PS/2 keyboard).
+
+    This handler reads the scancode from the keyboard controller (port 60h), adds it to the keyboard buffer (unless
+    it's full), and sends an EOI to the master PIC itself. It doesn't chain to the BIOS, so int 16h won't see any
+    keys until RestoreInterrupts() is called.
+
+    These are written in assembly, since they have to end with an iret, and they must not change any registers.
+
+*/
+
+__asm__ (
+  ".section .text.Interrupt, \"ax\" \n"
+
+  ".globl TimerHandler \n"
+  "TimerHandler: \n"
+  "  incl %cs:TimerTicks \n"
+  "  ljmpw *%cs:OldTimerVector \n"
+
+  ".globl KeyboardHandler \n"
+  "KeyboardHandler: \n"
+  "  pushw %ax \n"
+  "  pushw %bx \n"
+  "  inb $0x60, %al \n"
+  "  movzbw %cs:KeyboardHead, %bx \n"
+  "  movb %al, %cs:KeyboardBuffer(%bx) \n"
+  "  incb %bl \n"
+  "  andb $(" KeyboardBufferMask "), %bl \n"
+  "  cmpb %cs:KeyboardTail, %bl \n"
+  "  je 1f \n"
+  "  movb %bl, %cs:KeyboardHead \n"
+  "1: \n"
+  "  movb $0x20, %al \n"
+  "  outb %al, $0x20 \n"
+  "  popw %bx \n"
+  "  popw %ax \n"
+  "  iretw \n"
+
+  ".previous \n"
+);
+
+
+
+/*  GetVector(), SetVector(): Reads or writes an entry in the real mode IVT (at 0000h:0000h).
+
+    Input:        uint8 Vector                       - The interrupt vector you want to read or write.
+
+    Input:        uint32 Handler                     - (SetVector only) The new handler, as a segment:offset pair.
+
+    Output:       uint32                             - (GetVector only) The current handler, as a segment:offset pair.
+
+    The IVT starts at address 0, so it can't be accessed through a C pointer (the compiler is allowed to assume that
+    a null pointer is never dereferenced). Instead, these load 0 into FS and access the IVT through it explicitly.
+
+    As these are static functions, they are not accessible outside of this file.
+
+*/
+
+static uint32 GetVector(uint8 Vector) {
+
+  uint32 Handler;
+
+  __asm__ volatile("pushw %%fs; movw %w2, %%fs; movl %%fs:(%1), %0; popw %%fs" :
+                   "=r" (Handler) : "r" ((uint32)Vector * 4), "r" (0) : "memory");
+
+  return Handler;
+
+}
+
+static void SetVector(uint8 Vector, uint32 Handler) {
+
+  __asm__ volatile("pushw %%fs; movw %w2, %%fs; movl %0, %%fs:(%1); popw %%fs" :
+                   : "r" (Handler), "r" ((uint32)Vector * 4), "r" (0) : "memory");
+
+}
+
+
+
+/*  InstallInterrupts(): Replaces the BIOS's timer and keyboard interrupt handlers with our own.
+
+    (No inputs or outputs)
+
+    This function saves the current handlers for int 08h and int 09h, and points them to TimerHandler and
+    KeyboardHandler instead, with interrupts disabled while the IVT is being changed. It also resets the tick count
+    and empties the keyboard buffer. Calling it again before RestoreInterrupts() does nothing. This is in the Menu
+    overlay.
+
+*/
+
+OverlayEntry(Menu, InstallInterrupts);
+
+void Overlay(Menu) InstallInterrupts(void) {
+
+  if (Installed == true) return;
+
+  TimerTicks = 0;
+  KeyboardHead = 0;
+  KeyboardTail = 0;
+
+  __asm__ volatile("cli" : : : "memory");
+
+  OldTimerVector = GetVector(0x08);
+  OldKeyboardVector = GetVector(0x09);
+
+  SetVector(0x08, (uint32)&TimerHandler & 0xFFFF);
+  SetVector(0x09, (uint32)&KeyboardHandler & 0xFFFF);
+
+  __asm__ volatile("sti" : : : "memory");
+
+  Installed = true;
+
+}
+
+
+
+/*  RestoreInterrupts(): Puts the BIOS's timer and keyboard interrupt handlers back.
+
+    (No inputs or outputs)
+
+    This function undoes InstallInterrupts(), so that the BIOS (and int 16h) works as usual again. It must be called
+    before handing control over to anything else, and it's safe to call even if InstallInterrupts() wasn't.
+
+*/
+
+void RestoreInterrupts(void) {
+
+  if (Installed != true) return;
+
+  __asm__ volatile("cli" : : : "memory");
+
+  SetVector(0x08, OldTimerVector);
+  SetVector(0x09, OldKeyboardVector);
+
+  __asm__ volatile("sti" : : : "memory");
+
+  Installed = false;
+
+}
+
+
+
+/*  GetScancode(): Takes the next scancode out of the keyboard buffer.
+
+    Output:       uint8* Scancode                    - If there was a scancode in the buffer, it's written here.
+
+    Output:       bool                               - This returns true if there was a scancode in the buffer, and
+                                                     false if it was empty.
+
+    Keep in mind that these are raw (set 1) scancodes, so every key sends one when it's pressed, and another one
+    (with the highest bit set) when it's released. Some keys, like the arrow keys, also send E0h before them.
+
+*/
+
+OverlayEntry(Menu, GetScancode);
+
+bool Overlay(Menu) GetScancode(uint8* Scancode) {
+
+  if (KeyboardTail == KeyboardHead) return false;
+
+  *Scancode = KeyboardBuffer[KeyboardTail];
+  KeyboardTail = (KeyboardTail + 1) & (KeyboardBufferSize - 1);
+
+  return true;
+
+}
+
+
+
+/*  WaitForInterrupt(): Halts the CPU until the next interrupt.
+
+    (No inputs or outputs)
+
+    This function halts the CPU (with interrupts enabled), which is much better than spinning in a loop when there's
+    nothing to do. As the PIT fires about 18 times a second, it never waits for longer than that.
+
+*/
+
+OverlayEntry(Menu, WaitForInterrupt);
+
+void Overlay(Menu) WaitForInterrupt(void) {
+
+  __asm__ volatile("sti; hlt" : : : "memory");
+
+}
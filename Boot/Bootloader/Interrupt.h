@@ -0,0 +1,41 @@
+/* Ribeira | Written in 2022 by NunoLealF
+   To the extent possible under law, NunoLealF has waived all copyright and related or neighboring rights to this
+   software to the public domain worldwide. This software is distributed without any warranty.
+
+   You should have received a copy of the CC0 Public Domain Dedication along with this software.
+   If not, see <http://creativecommons.org/publicdomain/zero/1.0/>. */
+
+// WARNING: This is 16-bit C code. You should compile this, along with any other files from the second stage
+// bootloader, with the -m16 (or equivalent) flag.
+
+#ifndef _INTERRUPT_H_
+#define _INTERRUPT_H_
+
+// The keyboard buffer must be a power of two in size, since the interrupt handler wraps around it with a mask
+// (which is a string, as it's pasted into the handler's assembly).
+
+#define KeyboardBufferSize  32
+#define KeyboardBufferMask  "31"
+
+// The PIT fires about 18.2 times a second, so this is the amount of ticks in ten seconds (unlike the amount in one
+// second, this is a whole number).
+
+#define TicksPerTenSeconds  182
+
+#define ScancodeEnter       0x1C
+#define ScancodeUp          0x48
+#define ScancodeDown        0x50
+#define ScancodeExtended    0xE0
+
+extern volatile uint32 TimerTicks;
+
+void TimerHandler(void);
+void KeyboardHandler(void);
+
+void InstallInterrupts(void);
+void RestoreInterrupts(void);
+
+bool GetScancode(uint8* Scancode);
+void WaitForInterrupt(void);
+
+#endif
@@ -0,0 +1,154 @@
+/* Ribeira | Written in 2022 by NunoLealF
+   To the extent possible under law, NunoLealF has waived all copyright and related or neighboring rights to this
+   software to the public domain worldwide. This software is distributed without any warranty.
+
+   You should have received a copy of the CC0 Public Domain Dedication along with this software.
+   If not, see <http://creativecommons.org/publicdomain/zero/1.0/>. */
+
+// WARNING: This is 16-bit C code. You should compile this, along with any other files from the second stage
+// bootloader, with the -m16 (or equivalent) flag.
+
+#include "Stdint.h"
+#include "Graphics.h"
+#include "Bench.h"
+#include "Log.h"
+#include "Overlay.h"
+#include "Event.h"
+
+/*  LogRecordStruct: This is a struct that defines a single record in the boot log.
+
+    uint16 Event                                     - The number of the event, like EventE820 (see Log.h).
+
+    uint8 Severity                                   - How important the event is; LogDebug, LogInfo, LogWarning or
+                                                     LogError.
+
+    uint64 Timestamp                                 - The value of the TSC when the event was logged.
+
+    uint32 Arguments[4]                              - Up to four numbers that go with the event, like the amount of
+                                                     entries in the memory map. Unused arguments are zero.
+
+    LogStruct: This is a struct that defines the boot log itself, which is kept in the BootTable.
+
+    uint32 Total                                     - The amount of events that have been logged so far. If this is
+                                                     larger than Size, then only the last Size events are still there.
+
+    uint32 Size                                      - The amount of records in the ring, which is always LogSize.
+
+    LogRecordStruct Records[]                        - The ring itself; event number n is in Records[n % Size].
+
+    Logging an event only takes a handful of stores, so it's cheap enough to do anywhere. The text for every event is
+    only put together when it's needed (by RenderLog(), or by the kernel, which can show the same log later on).
+
+*/
+
+static LogStruct* Log;
+
+
+
+/*  InitializeLog(): Initializes the boot log.
+
+    Input:        LogStruct* Buffer                  - The area of memory you want to keep the log in (which should be
+                                                     in the BootTable, so that the kernel can find it).
+
+    This function clears out the log, and makes every other function in this file use it. It must be called before
+    LogEvent() or RenderLog().
+
+*/
+
+void InitializeLog(LogStruct* Buffer) {
+
+  Log = Buffer;
+
+  Log->Total = 0;
+  Log->Size = LogSize;
+
+}
+
+
+
+/*  LogEvent(): Adds an event to the boot log.
+
+    Input:        uint16 Event                       - The event you want to log, like EventE820.
+
+    Input:        uint8 Severity                     - How important the event is, like LogInfo.
+
+    Input:        uint32 Argument0 ~ Argument3       - The numbers that go with the event. If the event's message
+                                                     doesn't use some of them, just set them to zero.
+
+    This function adds a record to the boot log, overwriting the oldest one if the log is full. It doesn't show
+    anything on the screen; that's left to RenderLog().
+
+*/
+
+void LogEvent(uint16 Event, uint8 Severity, uint32 Argument0, uint32 Argument1, uint32 Argument2, uint32 Argument3) {
+
+  LogRecordStruct* Record = &Log->Records[Log->Total % LogSize];
+
+  Record->Event = Event;
+  Record->Severity = Severity;
+  Record->Timestamp = ReadTsc();
+  Record->Arguments[0] = Argument0;
+  Record->Arguments[1] = Argument1;
+  Record->Arguments[2] = Argument2;
+  Record->Arguments[3] = Argument3;
+
+  Log->Total++;
+
+}
+
+
+
+/*  RenderLog(): Shows the boot log on the terminal.
+
+    Input:        uint8 Severity                     - The least important events you want to show. For example,
+                                                     LogInfo shows everything but debug events.
+
+    This function goes through every event that's still in the log (oldest first), and prints the message for each
+    one (from Event.h), replacing %0 to %3 with its arguments in decimal, and #0 to #3 with its arguments in hex.
+    Warnings and errors are shown in red, and debug events in grey.
+
+    Since the log is only shown once (or when we crash), this is in the Log overlay, along with the messages. The
+    overlay is loaded the first time this is called (see OverlayEntry()).
+
+*/
+
+OverlayEntry(Log, RenderLog);
+
+void Overlay(Log) RenderLog(uint8 Severity) {
+
+  uint32 First = (Log->Total > LogSize) ? (Log->Total - LogSize) : 0;
+
+  for (uint32 i = First; i < Log->Total; i++) {
+
+    LogRecordStruct* Record = &Log->Records[i % LogSize];
+
+    if (Record->Severity < Severity) continue;
+    if (Record->Event >= (sizeof(EventMessage) / sizeof(EventMessage[0]))) continue;
+
+    const char* Message = EventMessage[Record->Event];
+    uint8 Color = (Record->Severity >= LogWarning) ? 0x0C : ((Record->Severity == LogDebug) ? 0x07 : 0x0F);
+
+    for (uint16 j = 0; (j < EventMessageSize) && (Message[j] != '\0'); j++) {
+
+      if (((Message[j] == '%') || (Message[j] == '#')) && ((j + 1) < EventMessageSize) &&
+          (Message[j + 1] >= '0') && (Message[j + 1] <= '3')) {
+
+        char Buffer[12];
+        Itoa(Record->Arguments[Message[j + 1] - '0'], Buffer, (Message[j] == '%') ? 10 : 16);
+
+        Print(Buffer, 0x07);
+        j++;
+
+      } else {
+
+        Putchar(Message[j], Color);
+
+      }
+
+    }
+
+    Print("\n\r", Color);
+
+  }
+
+}
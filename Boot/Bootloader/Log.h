@@ -0,0 +1,66 @@
+/* Ribeira | Written in 2022 by NunoLealF
+   To the extent possible under law, NunoLealF has waived all copyright and related or neighboring rights to this
+   software to the public domain worldwide. This software is distributed without any warranty.
+
+   You should have received a copy of the CC0 Public Domain Dedication along with this software.
+   If not, see <http://creativecommons.org/publicdomain/zero/1.0/>. */
+
+// WARNING: This is 16-bit C code. You should compile this, along with any other files from the second stage
+// bootloader, with the -m16 (or equivalent) flag.
+
+#ifndef _LOG_H_
+#define _LOG_H_
+
+// The boot log is a ring of LogSize records in the BootTable. Only the event number and its arguments are stored;
+// the text for every event is in Event.h, and it's only put together when the log is shown, with RenderLog().
+
+#define LogSize         64
+
+#define LogDebug        0
+#define LogInfo         1
+#define LogWarning      2
+#define LogError        3
+
+// These are the events that can be logged, which are the indexes of EventMessage[] in Event.h. Keep them in sync.
+
+#define EventStart          0
+#define EventDisk           1
+#define EventCacheHit       2
+#define EventE820           3
+#define EventMemtest        4
+#define EventMemtestSkipped 5
+#define EventEdd            6
+#define EventCacheStored    7
+#define EventCacheNotStored 8
+#define EventRsdp           9
+#define EventSmbios         10
+#define EventModule         11
+#define EventNoModule       12
+#define EventNoArchive      13
+#define EventMenu           14
+#define EventUnreal         15
+#define EventNoA20          16
+
+typedef volatile struct _LogRecordStruct_ {
+
+  uint16                  Event;
+  uint8                   Severity;
+  uint8                   Reserved;
+  uint64                  Timestamp;
+  uint32                  Arguments[4];
+
+} __attribute__((packed)) LogRecordStruct;
+
+typedef volatile struct _LogStruct_ {
+
+  uint32                  Total;
+  uint32                  Size;
+  LogRecordStruct         Records[LogSize];
+
+} __attribute__((packed)) LogStruct;
+
+void InitializeLog(LogStruct* Buffer);
+void LogEvent(uint16 Event, uint8 Severity, uint32 Argument0, uint32 Argument1, uint32 Argument2, uint32 Argument3);
+void RenderLog(uint8 Severity);
+
+#endif
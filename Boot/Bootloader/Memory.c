@@ -102,6 +102,179 @@ uint32 __attribute__((noinline)) GetMemoryMapEntry(MemoryMapEntryStruct* Entry,
 
 
 
+/*  AllocatorStruct: This is a struct that keeps track of the memory that the bootloader can allocate.
+
+    uint32 Next                                      - The (linear) address of the next free byte.
+
+    uint32 End                                       - The (linear) address right after the last free byte.
+
+    The allocator is a very simple 'bump' allocator; it takes the largest usable area of memory from the memory map
+    that's between 1MiB and 4GiB, and hands it out from the start, without ever freeing anything. Anything it hands out
+    is meant to be passed on to the kernel (like boot modules), so there's no need to free it.
+
+*/
+
+typedef struct _AllocatorStruct_ {
+
+  uint32                  Next;
+  uint32                  End;
+
+} AllocatorStruct;
+
+AllocatorStruct Allocator;
+
+
+
+/*  InitializeAllocator(): This function initializes the allocator, using the given memory map.
+
+    Input:        MemoryMapEntryStruct* MemoryMap    - The memory map of the system, after it's been tested (if at all).
+
+    Input:        uint32 LastEntry                   - The number of the last entry in the memory map.
+
+    Output:       uint32                             - The amount of memory available to the allocator, in bytes. If
+                                                     this is 0, then there's no usable memory above 1MiB.
+
+    This function finds the largest usable (type 1) area of memory between 1MiB and 4GiB in the memory map, and
+    initializes the Allocator struct with it. Memory under 1MiB is never used, as that's where the bootloader, the
+    BootTable, the BIOS and the disk buffers all live.
+
+*/
+
+uint32 InitializeAllocator(MemoryMapEntryStruct* MemoryMap, uint32 LastEntry) {
+
+  Allocator.Next = 0;
+  Allocator.End = 0;
+
+  for (uint32 i = 0; i <= LastEntry; i++) {
+
+    if ((MemoryMap[i].Type != 1) || (MemoryMap[i].HighBaseAddress != 0)) continue;
+
+    uint32 Base = MemoryMap[i].LowBaseAddress;
+    uint32 End = Base + MemoryMap[i].LowEntryLength;
+
+    if ((MemoryMap[i].HighEntryLength != 0) || (End < Base)) End = 0xFFFFF000;
+    if (Base < 0x100000) Base = 0x100000;
+
+    if ((End > Base) && ((End - Base) > (Allocator.End - Allocator.Next))) {
+
+      Allocator.Next = Base;
+      Allocator.End = End;
+
+    }
+
+  }
+
+  return (Allocator.End - Allocator.Next);
+
+}
+
+
+
+/*  Allocate(): This function allocates an area of memory.
+
+    Input:        uint32 Size                        - The size of the area you want to allocate, in bytes.
+
+    Input:        uint32 Alignment                   - The alignment of the area you want to allocate, in bytes. This
+                                                     must be a power of two (like 4096).
+
+    Output:       uint32                             - The (linear) address of the area that was allocated, or 0 if
+                                                     there isn't enough memory left.
+
+    This function allocates Size bytes from the allocator (see InitializeAllocator()), aligned to Alignment bytes.
+    Keep in mind that the address it returns is above 1MiB, so you can't use it as a buffer for BIOS calls.
+
+*/
+
+uint32 Allocate(uint32 Size, uint32 Alignment) {
+
+  uint32 Address = (Allocator.Next + (Alignment - 1)) & ~(Alignment - 1);
+
+  if ((Allocator.Next == 0) || (Address < Allocator.Next) || (Address > Allocator.End) ||
+      (Size > (Allocator.End - Address))) {
+
+    return 0;
+
+  }
+
+  Allocator.Next = Address + Size;
+  return Address;
+
+}
+
+
+
+/*  GetLowMemorySize(): This function calls the BIOS function int 12h to get the amount of conventional memory.
+
+    Output:       uint32                             - The amount of conventional memory (memory under 1MiB that we
+                                                     can use), in KiB. This is usually somewhere around 639KiB.
+
+    This function calls the BIOS function int 12h, which returns the amount of conventional memory in KiB in ax.
+    It's not as useful as the memory map from E820, but it's much faster, and it's supported by every BIOS.
+
+*/
+
+uint32 GetLowMemorySize(void) {
+
+  uint32 Size = 0;
+
+  __asm__ volatile( "int $0x12" : "=a" (Size) : : "cc");
+
+  return (Size & 0xFFFF);
+
+}
+
+
+
+/*  GetExtendedMemorySize(): This function calls the BIOS function int 15h ax e801h to get the extended memory size.
+
+    Output:       uint32                             - The amount of extended memory (memory above 1MiB) in KiB, or 0 if
+                                                     it couldn't be found.
+
+    This function calls the BIOS function int 15h, ax e801h, which returns the amount of memory between 1MiB and 16MiB
+    in KiB in ax (or cx), and the amount of memory above 16MiB in 64KiB blocks in bx (or dx). If that isn't supported,
+    it falls back to int 15h, ah 88h, which returns the amount of extended memory in KiB in ax, up to 64MiB.
+
+    Like GetLowMemorySize(), this is nowhere near as detailed as the memory map from E820, but it's a quick way to find
+    out how much memory the BIOS thinks the system has.
+
+*/
+
+uint32 GetExtendedMemorySize(void) {
+
+  uint32 Ax = 0xE801;
+  uint32 Bx = 0;
+  uint32 Cx = 0;
+  uint32 Dx = 0;
+  uint8 Carry = 1;
+
+  __asm__ volatile( "int $0x15; setc %0" :
+                    "=qm" (Carry), "+a" (Ax), "+b" (Bx), "+c" (Cx), "+d" (Dx) :
+                    :
+                    "cc");
+
+  if (Carry == 0) {
+
+    if ((Ax & 0xFFFF) == 0) {
+
+      Ax = Cx;
+      Bx = Dx;
+
+    }
+
+    return (Ax & 0xFFFF) + ((Bx & 0xFFFF) * 64);
+
+  }
+
+  Ax = 0x8800;
+
+  __asm__ volatile( "int $0x15; setc %0" : "=qm" (Carry), "+a" (Ax) : : "cc");
+
+  return (Carry == 0) ? (Ax & 0xFFFF) : 0;
+
+}
+
+
+
 /*  Memset(): This function writes over an area of memory.
 
     Input/Output: void* Address                      - This specifies the base memory address to start writing to.
@@ -222,10 +395,13 @@ void* Memmove(void* restrict DestinationAddress, const void* restrict SourceAddr
                                                      compared.
 
     Output:       int                                - This is the return value. It returns 0 if the chosen memory
-                                                     areas are identical; otherwise, it returns -+1.
+                                                     areas are identical; otherwise, it returns 1 if the first byte
+                                                     that differs is larger at Address2, or -1 if it's larger at
+                                                     Address1 (the same as memcmp(Address2, Address1, Size)).
 
     This function compares two areas in memory; it compares a Size amount of bytes from Address1 to a Size amount of
-    bytes from Address2, and returns 0 if the two are equal, and -+1 if they are not.
+    bytes from Address2, byte by byte (as unsigned numbers), and returns 0 if the two are equal, and -+1 if they are
+    not.
     You could use this, for example, to compare two tables of the same type, and see if the content in them is equal,
     by calling something like Memcmp(&Table2, &Table1, (sizeof(TableType))).
 
@@ -237,11 +413,58 @@ int Memcmp(void* Address2, void* Address1, unsigned long Size) {
 
   for (i = 0; i < Size; i++) {
 
-    if (((uint8*)Address1) < ((uint8*)Address2)) return 1;
-    if (((uint8*)Address2) < ((uint8*)Address1)) return -1;
+    if (((uint8*)Address1)[i] < ((uint8*)Address2)[i]) return 1;
+    if (((uint8*)Address2)[i] < ((uint8*)Address1)[i]) return -1;
 
   }
 
   return 0;
 
 }
+
+
+
+/*  Checksum(): This function calculates a checksum of an area in memory.
+
+    Input:        void* Address                      - This is the base address of the area of memory you want to
+                                                     calculate a checksum of.
+
+    Input:        unsigned long Size                 - This is the size, in bytes, of that area of memory.
+
+    Output:       uint32                             - This is the checksum of that area of memory.
+
+    This function calculates an Adler-32 checksum of an area in memory. It keeps two 16-bit sums; one of every byte,
+    and one of every intermediate value of the first sum, which makes it sensitive to the order of the bytes, not just
+    their values. It's not as strong as a CRC, but it's much faster, and it's good enough to find out if something on
+    disk was changed or corrupted.
+
+    Both sums are only reduced (modulo 65521) every 5552 bytes, which is the most we can go without them overflowing.
+
+*/
+
+uint32 Checksum(void* Address, unsigned long Size) {
+
+  uint32 A = 1;
+  uint32 B = 0;
+  unsigned long i = 0;
+
+  while (i < Size) {
+
+    unsigned long Chunk = ((Size - i) > 5552) ? 5552 : (Size - i);
+
+    for (unsigned long j = 0; j < Chunk; j++) {
+
+      A += ((uint8*)Address)[i + j];
+      B += A;
+
+    }
+
+    A %= 65521;
+    B %= 65521;
+    i += Chunk;
+
+  }
+
+  return (B << 16) | A;
+
+}
@@ -23,10 +23,17 @@ typedef volatile struct _MemoryMapEntryStruct_ {
 } __attribute__((packed)) MemoryMapEntryStruct;
 
 int __attribute__((noinline)) GetMemoryMapEntry(MemoryMapEntryStruct* Entry, volatile uint32 EntryNum);
+uint32 GetLowMemorySize(void);
+uint32 GetExtendedMemorySize(void);
+
+uint32 InitializeAllocator(MemoryMapEntryStruct* MemoryMap, uint32 LastEntry);
+uint32 Allocate(uint32 Size, uint32 Alignment);
 
 void* Memset (void* Address, uint8 Value, unsigned long Size);
 void* Memcpy (void* restrict DestinationAddress, const void* restrict SourceAddress, unsigned long Size);
 void* Memmove(void* restrict DestinationAddress, const void* restrict SourceAddress, unsigned long Size);
 int   Memcmp (void* Address2, void* Address1, unsigned long Size);
 
+uint32 Checksum(void* Address, unsigned long Size);
+
 #endif
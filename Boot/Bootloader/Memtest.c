@@ -0,0 +1,362 @@
+/* Ribeira | Written in 2022 by NunoLealF
+   To the extent possible under law, NunoLealF has waived all copyright and related or neighboring rights to this
+   software to the public domain worldwide. This software is distributed without any warranty.
+
+   You should have received a copy of the CC0 Public Domain Dedication along with this software.
+   If not, see <http://creativecommons.org/publicdomain/zero/1.0/>. */
+
+// WARNING: This is 16-bit C code. You should compile this, along with any other files from the second stage
+// bootloader, with the -m16 (or equivalent) flag.
+
+#include "Stdint.h"
+#include "Memory.h"
+#include "Memtest.h"
+#include "Unreal.h"
+#include "Overlay.h"
+
+// The memory test works on 64KiB blocks. A quick test only samples the first block of every 1MiB (so it touches
+// 64MiB per GiB of RAM), while a thorough test goes over every block. Anything under 1MiB is never tested, as that's
+// where the bootloader, the stack, the BootTable and the BIOS data all live. Everything in here is in the Memtest
+// overlay, which is loaded the first time TestMemoryMap() or MarkBadMemory() are called.
+
+#define MemtestBlockSize      0x10000
+#define MemtestQuickStride    0x100000
+#define MemtestLowLimit       0x100000
+#define MemtestMaxRuns        16
+
+// 1MiB / 18.2065Hz, in hundredths of a KiB per tick. This converts KiB/tick into MB/s without needing division of
+// 64-bit values (which would need libgcc).
+
+#define MemtestKiBPerTickMBs  5624
+
+
+
+/*  BiosTicks(): Reads the BIOS tick counter.
+
+    Output:       uint32                             - The amount of timer ticks since midnight, as kept by the BIOS in
+                                                     the BIOS Data Area at 46Ch. It goes up roughly 18.2 times a second.
+
+    This function reads the tick counter that the BIOS keeps at 46Ch in memory. It's not very precise (each tick is
+    about 55ms), but it's always there, and it's more than enough to measure something that takes a few seconds.
+    As this is a static function, it is not accessible outside of this file.
+
+*/
+
+static uint32 Overlay(Memtest) BiosTicks(void) {
+
+  return *(volatile uint32*)0x046C;
+
+}
+
+
+
+/*  TestBlock(): Tests a single block of memory.
+
+    Input:        uint32 Base                        - The (linear) base address of the block you want to test. The
+                                                     block is always MemtestBlockSize bytes long.
+
+    Input:        uint32 Invert                      - This value is XORed with every pattern, so you can use
+                                                     FFFFFFFFh to test the inverse of each pattern.
+
+    Output:       bool                               - This returns true if the block passed, and false if it didn't.
+
+    This function runs two patterns over a block of memory. First, it writes a 'walking ones' pattern (a single bit
+    set, moving up one bit with every dword), and then an 'address-in-address' pattern, where each dword contains its
+    own address. Each pattern is streamed into the whole block one dword at a time, and then read back.
+
+    The walking ones pattern mostly finds stuck or shorted data lines, while the address-in-address pattern finds
+    address lines that are stuck, or that alias other addresses within the block.
+    As this is a static function, it is not accessible outside of this file.
+
+*/
+
+static bool Overlay(Memtest) TestBlock(uint32 Base, uint32 Invert) {
+
+  volatile uint32* Block = (volatile uint32*)Base;
+  uint32 Count = (MemtestBlockSize / 4);
+  uint32 Bit;
+
+  // Walking ones.
+
+  Bit = 1;
+
+  for (uint32 i = 0; i < Count; i++) {
+
+    Block[i] = Bit ^ Invert;
+    Bit = (Bit << 1) | (Bit >> 31);
+
+  }
+
+  Bit = 1;
+
+  for (uint32 i = 0; i < Count; i++) {
+
+    if (Block[i] != (Bit ^ Invert)) return false;
+    Bit = (Bit << 1) | (Bit >> 31);
+
+  }
+
+  // Address-in-address.
+
+  for (uint32 i = 0; i < Count; i++) {
+
+    Block[i] = (Base + (i << 2)) ^ Invert;
+
+  }
+
+  for (uint32 i = 0; i < Count; i++) {
+
+    if (Block[i] != ((Base + (i << 2)) ^ Invert)) return false;
+
+  }
+
+  return true;
+
+}
+
+
+
+/*  MarkBadMemory(): Marks a range of usable memory in the memory map as bad memory.
+
+    Input/Output: MemoryMapEntryStruct* MemoryMap    - The memory map you want to modify.
+
+    Input/Output: uint32* LastEntry                  - The number of the last entry in the memory map. This is updated
+                                                     if any new entries have to be added.
+
+    Input:        uint32 MaxEntries                  - The maximum amount of entries that fit in the memory map.
+
+    Input:        uint32 Base, Length                - The base address and length of the range you want to mark as bad.
+
+    Output:       bool                               - This returns true if the range was marked as bad, or false if it
+                                                     isn't inside of any usable (type 1) entry.
+
+    This function finds the usable (type 1) entry that contains the given range, and splits it into up to three entries:
+    the usable memory before the range, the range itself (as type 5, or bad memory), and the usable memory after it.
+    Every entry after it is moved up to make room.
+
+    If the memory map doesn't have enough room for the new entries, the bad range is extended to the end (and if that's
+    still not enough, to the start) of the entry it's in. This throws away some good memory, but it never leaves bad
+    memory marked as usable.
+
+*/
+
+OverlayEntry(Memtest, MarkBadMemory);
+
+bool Overlay(Memtest) MarkBadMemory(MemoryMapEntryStruct* MemoryMap, uint32* LastEntry, uint32 MaxEntries,
+                                    uint32 Base, uint32 Length) {
+
+  for (uint32 i = 0; i <= *LastEntry; i++) {
+
+    if (MemoryMap[i].Type != 1) continue;
+
+    uint64 EntryBase   = ((uint64)MemoryMap[i].HighBaseAddress << 32) | MemoryMap[i].LowBaseAddress;
+    uint64 EntryLength = ((uint64)MemoryMap[i].HighEntryLength << 32) | MemoryMap[i].LowEntryLength;
+
+    if ((Base < EntryBase) || ((Base + (uint64)Length) > (EntryBase + EntryLength))) continue;
+
+    // Work out how much usable memory is left before and after the bad range, and how many extra entries we need.
+
+    uint64 Head = Base - EntryBase;
+    uint64 Tail = (EntryBase + EntryLength) - (Base + (uint64)Length);
+
+    uint32 Free = (MaxEntries - 1) - *LastEntry;
+
+    if ((Free < 2) && (Head != 0) && (Tail != 0)) Tail = 0;
+    if ((Free < 1) && (Tail != 0)) Tail = 0;
+    if ((Free < 1) && (Head != 0)) Head = 0;
+
+    uint32 Extra = ((Head != 0) ? 1 : 0) + ((Tail != 0) ? 1 : 0);
+
+    // Move every entry after this one up, to make room for the extra entries.
+
+    for (uint32 j = *LastEntry; j > i; j--) {
+
+      Memcpy((void*)&MemoryMap[j + Extra], (void*)&MemoryMap[j], sizeof(MemoryMapEntryStruct));
+
+    }
+
+    *LastEntry += Extra;
+
+    uint32 Acpi = MemoryMap[i].UnusedAcpi;
+    uint64 Position = EntryBase;
+    uint64 Sizes[3] = {Head, (EntryLength - Head - Tail), Tail};
+    uint32 Types[3] = {1, 5, 1};
+
+    for (uint32 j = 0; j < 3; j++) {
+
+      if (Sizes[j] == 0) continue;
+
+      MemoryMap[i].LowBaseAddress  = (uint32)Position;
+      MemoryMap[i].HighBaseAddress = (uint32)(Position >> 32);
+      MemoryMap[i].LowEntryLength  = (uint32)Sizes[j];
+      MemoryMap[i].HighEntryLength = (uint32)(Sizes[j] >> 32);
+      MemoryMap[i].Type            = Types[j];
+      MemoryMap[i].UnusedAcpi      = Acpi;
+
+      Position += Sizes[j];
+      i++;
+
+    }
+
+    return true;
+
+  }
+
+  return false;
+
+}
+
+
+
+/*  TestMemoryMap(): Tests the usable memory in the memory map, and marks any bad ranges as bad memory.
+
+    Input/Output: MemoryMapEntryStruct* MemoryMap    - The memory map you want to test, as returned by E820.
+
+    Input/Output: uint32* LastEntry                  - The number of the last entry in the memory map.
+
+    Input:        uint32 MaxEntries                  - The maximum amount of entries that fit in the memory map.
+
+    Input:        uint8 Level                        - How thorough the test should be; this can be MemtestQuick or
+                                                     MemtestThorough. Anything else is treated as MemtestQuick.
+
+    Output:       MemtestResultStruct* Result        - This is filled out with the amount of memory tested (in KiB), how
+                                                     many bad ranges were found, how many BIOS ticks the test took, and
+                                                     the throughput of the test in MB/s.
+
+    Output:       bool                               - This returns false if the test couldn't run (because the A20
+                                                     line is disabled), and true otherwise.
+
+    This function goes over every usable (type 1) entry in the memory map that's between 1MiB and 4GiB, and tests it
+    in blocks of 64KiB. A quick test runs the walking ones and address-in-address patterns over the first block of
+    every 1MiB, and a thorough test runs those patterns (and their inverse) over every block.
+
+    Any range that fails gets rewritten in the memory map as bad memory (type 5), so nothing else will try to use it.
+    With a quick test, the whole 1MiB that the block was sampled from is marked as bad, since the rest of it wasn't
+    tested.
+
+    Keep in mind that this overwrites the contents of every block it tests.
+
+*/
+
+OverlayEntry(Memtest, TestMemoryMap);
+
+bool Overlay(Memtest) TestMemoryMap(MemoryMapEntryStruct* MemoryMap, uint32* LastEntry, uint32 MaxEntries,
+                                    uint8 Level, MemtestResultStruct* Result) {
+
+  Memset((void*)Result, 0, sizeof(MemtestResultStruct));
+
+  if (A20Enabled() != true) {
+
+    return false;
+
+  }
+
+  uint32 Stride = (Level == MemtestThorough) ? MemtestBlockSize : MemtestQuickStride;
+  uint32 Traffic = (Level == MemtestThorough) ? 8 : 4;
+
+  uint32 StartTicks = BiosTicks();
+
+  for (uint32 i = 0; i <= *LastEntry; i++) {
+
+    // Only test usable memory that starts below 4GiB, and clip it to 1MiB - 4GiB.
+
+    if ((MemoryMap[i].Type != 1) || (MemoryMap[i].HighBaseAddress != 0)) continue;
+
+    uint32 Base = MemoryMap[i].LowBaseAddress;
+    uint32 End  = Base + MemoryMap[i].LowEntryLength;
+
+    if ((MemoryMap[i].HighEntryLength != 0) || (End < Base)) {
+
+      End = (0 - MemtestBlockSize);
+
+    }
+
+    if (Base < MemtestLowLimit) Base = MemtestLowLimit;
+    Base = (Base + (MemtestBlockSize - 1)) & ~(uint32)(MemtestBlockSize - 1);
+
+    // Test each block, and keep track of the ranges that failed, merging them when they're next to each other. If
+    // we run out of room, the last range is just extended, which is fine, since it's still within the same entry.
+
+    uint32 BadBase[MemtestMaxRuns];
+    uint32 BadLength[MemtestMaxRuns];
+    uint32 Runs = 0;
+
+    for (uint32 Block = Base; (Block < End) && ((End - Block) >= MemtestBlockSize); Block += Stride) {
+
+      bool Passed = TestBlock(Block, 0);
+
+      if ((Passed == true) && (Level == MemtestThorough)) {
+
+        Passed = TestBlock(Block, 0xFFFFFFFF);
+
+      }
+
+      Result->TestedKiB += (MemtestBlockSize / 1024);
+
+      if (Passed != true) {
+
+        uint32 Length = ((End - Block) < Stride) ? (End - Block) : Stride;
+
+        if ((Runs > 0) && ((BadBase[Runs - 1] + BadLength[Runs - 1]) == Block)) {
+
+          BadLength[Runs - 1] += Length;
+
+        } else if (Runs < MemtestMaxRuns) {
+
+          BadBase[Runs] = Block;
+          BadLength[Runs] = Length;
+          Runs++;
+
+        } else {
+
+          BadLength[Runs - 1] = (Block + Length) - BadBase[Runs - 1];
+
+        }
+
+      }
+
+      if ((End - Block) <= Stride) break;
+
+    }
+
+    // Mark every range that failed as bad memory. Splitting an entry only ever adds entries right after it, so we
+    // can skip over them afterwards, as they've already been tested.
+
+    uint32 PreviousLastEntry = *LastEntry;
+
+    for (uint32 j = 0; j < Runs; j++) {
+
+      if (MarkBadMemory(MemoryMap, LastEntry, MaxEntries, BadBase[j], BadLength[j]) == true) {
+
+        Result->BadRanges++;
+
+      }
+
+    }
+
+    i += (*LastEntry - PreviousLastEntry);
+
+  }
+
+  // Work out how long the test took (accounting for the tick counter rolling over at midnight), and the throughput.
+
+  uint32 EndTicks = BiosTicks();
+
+  if (EndTicks < StartTicks) EndTicks += 0x1800B0;
+
+  // TestedKiB * Traffic * 100 can overflow 32 bits when testing close to 4GiB, so the amount of KiB per tick is
+  // worked out first (as a whole part and a remainder), and only then scaled by 100. Neither part can overflow, since
+  // less than 4GiB is ever tested, and a test always takes less than 1800B0h ticks.
+
+  Result->Ticks = EndTicks - StartTicks;
+  uint32 Ticks = (Result->Ticks == 0) ? 1 : Result->Ticks;
+  uint32 Transferred = Result->TestedKiB * Traffic;
+
+  uint32 Whole = (Transferred / Ticks) * 100;
+  uint32 Fraction = ((Transferred % Ticks) * 100) / Ticks;
+
+  Result->Throughput = (Whole + Fraction) / MemtestKiBPerTickMBs;
+
+  return true;
+
+}
@@ -0,0 +1,37 @@
+/* Ribeira | Written in 2022 by NunoLealF
+   To the extent possible under law, NunoLealF has waived all copyright and related or neighboring rights to this
+   software to the public domain worldwide. This software is distributed without any warranty.
+
+   You should have received a copy of the CC0 Public Domain Dedication along with this software.
+   If not, see <http://creativecommons.org/publicdomain/zero/1.0/>. */
+
+// WARNING: This is 16-bit C code. You should compile this, along with any other files from the second stage
+// bootloader, with the -m16 (or equivalent) flag.
+
+#ifndef _MEMTEST_H_
+#define _MEMTEST_H_
+
+#define MemtestOff       0
+#define MemtestQuick     1
+#define MemtestThorough  2
+
+#ifndef MemtestLevel
+#define MemtestLevel     MemtestOff
+#endif
+
+typedef struct _MemtestResultStruct_ {
+
+  uint32                  TestedKiB;
+  uint32                  BadRanges;
+  uint32                  Ticks;
+  uint32                  Throughput;
+
+} MemtestResultStruct;
+
+bool MarkBadMemory(MemoryMapEntryStruct* MemoryMap, uint32* LastEntry, uint32 MaxEntries,
+                   uint32 Base, uint32 Length);
+
+bool TestMemoryMap(MemoryMapEntryStruct* MemoryMap, uint32* LastEntry, uint32 MaxEntries,
+                   uint8 Level, MemtestResultStruct* Result);
+
+#endif
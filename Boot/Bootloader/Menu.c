@@ -0,0 +1,229 @@
+/* Ribeira | Written in 2022 by NunoLealF
+   To the extent possible under law, NunoLealF has waived all copyright and related or neighboring rights to this
+   software to the public domain worldwide. This software is distributed without any warranty.
+
+   You should have received a copy of the CC0 Public Domain Dedication along with this software.
+   If not, see <http://creativecommons.org/publicdomain/zero/1.0/>. */
+
+// WARNING: This is 16-bit C code. You should compile this, along with any other files from the second stage
+// bootloader, with the -m16 (or equivalent) flag.
+
+#include "Stdint.h"
+#include "Graphics.h"
+#include "Interrupt.h"
+#include "Menu.h"
+#include "Overlay.h"
+
+/*  BootEntryStruct: This is a struct that defines an entry in the boot menu.
+
+    const char* Name                                 - The name of the entry, as it's shown in the boot menu.
+
+    const char* Modules[]                            - The names of the modules (in the module archive) that this entry
+                                                     needs, in the order they should be loaded. Unused slots are zero.
+
+    The boot menu is drawn at the top of the screen, with the title on the first line, one line for every entry, and
+    the countdown under that. Since the boot log is only shown at the end (see Log.c), the screen is still empty when
+    the menu is shown, and it gets cleared again once an entry has been chosen.
+
+    Everything in this file is in the Menu overlay, since it only runs once per boot (and not at all if the timeout
+    is zero). The overlay is loaded the first time BootMenu() is called.
+
+*/
+
+#define MenuEntryRow    2
+
+
+
+/*  DrawLine(): Draws a line of the boot menu.
+
+    Input:        uint16 Row                         - The line of the terminal you want to draw on.
+
+    Input:        const char* Prefix, String         - What you want to show on that line (one after the other).
+
+    Input:        uint8 Color                        - The color attribute of the line.
+
+    This function moves the cursor to the start of the line, prints the prefix and the string, and fills the rest of
+    the line with spaces (in the same color), so that whatever was there before is overwritten.
+    As this is a static function, it is not accessible outside of this file.
+
+*/
+
+static void Overlay(Menu) DrawLine(uint16 Row, const char* Prefix, const char* String, uint8 Color) {
+
+  Terminal.X = 0;
+  Terminal.Y = Row;
+
+  Print(Prefix, Color);
+  Print(String, Color);
+
+  while (Terminal.X < (Terminal.Max_X - 1)) Putchar(' ', Color);
+
+}
+
+
+
+/*  DrawCountdown(): Draws the countdown line of the boot menu.
+
+    Input:        uint16 Row                         - The line of the terminal the countdown is on.
+
+    Input:        uint16 Seconds                     - The amount of seconds left, or 0 if the countdown was stopped.
+
+    As this is a static function, it is not accessible outside of this file.
+
+*/
+
+static void Overlay(Menu) DrawCountdown(uint16 Row, uint16 Seconds) {
+
+  if (Seconds == 0) {
+
+    DrawLine(Row, "Use the arrow keys to choose an entry, and press Enter to boot it.", "", 0x07);
+
+  } else {
+
+    char Buffer[8];
+    Itoa(Seconds, Buffer, 10);
+
+    DrawLine(Row, "Booting the highlighted entry in ", Buffer, 0x07);
+    Print(" second(s); press any key to stop.", 0x07);
+
+  }
+
+}
+
+
+
+/*  BootMenu(): Shows the boot menu, and waits for an entry to be chosen.
+
+    Input:        const BootEntryStruct* Entries     - The entries you want to show in the boot menu.
+
+    Input:        uint8 Count                        - The amount of entries (up to MenuMaxEntries).
+
+    Input:        uint8 Default                      - The entry that's highlighted at first, and that gets booted if
+                                                     the countdown runs out.
+
+    Input:        uint16 Timeout                     - The length of the countdown, in seconds. If this is zero, the
+                                                     menu isn't shown, and the default entry is chosen straight away.
+
+    Input:        bool (*Idle)(void)                 - A function that does a little bit of work in the background (like
+                                                     reading the next few sectors of the default entry's modules), and
+                                                     returns true if there's more to do, or false if there isn't. This
+                                                     can be zero.
+
+    Output:       uint8                              - The entry that was chosen.
+
+    This function hooks the timer and keyboard interrupts (see Interrupt.c), draws the menu, and then loops until the
+    countdown runs out or Enter is pressed. Pressing any key stops the countdown, and the arrow keys move between the
+    entries. Whenever there's nothing else to do, it calls Idle(), and once that's done too, it halts the CPU until
+    the next interrupt, instead of spinning. The interrupts are restored, and the screen cleared, before returning.
+
+*/
+
+OverlayEntry(Menu, BootMenu);
+
+uint8 Overlay(Menu) BootMenu(const BootEntryStruct* Entries, uint8 Count, uint8 Default, uint16 Timeout,
+                             bool (*Idle)(void)) {
+
+  if ((Timeout == 0) || (Count == 0)) return Default;
+  if (Count > MenuMaxEntries) Count = MenuMaxEntries;
+  if (Default >= Count) Default = 0;
+
+  uint8 Selected = Default;
+  uint16 CountdownRow = MenuEntryRow + Count + 1;
+
+  // Draw the menu, and start counting down.
+
+  InstallInterrupts();
+
+  DrawLine(0, "Ribeira bootloader. Choose a boot entry:", "", 0x0F);
+
+  for (uint8 i = 0; i < Count; i++) {
+    DrawLine(MenuEntryRow + i, "  ", Entries[i].Name, (i == Selected) ? 0x70 : 0x07);
+  }
+
+  uint32 Deadline = ((uint32)Timeout * TicksPerTenSeconds) / 10;
+  uint16 Shown = 0;
+  bool Counting = true;
+  bool Chosen = false;
+
+  while (Chosen != true) {
+
+    // Go through every key that was pressed since the last time. Key releases (and the E0h prefix that comes before
+    // the arrow keys on some keyboards) are ignored.
+
+    uint8 Scancode;
+
+    while ((Chosen != true) && (GetScancode(&Scancode) == true)) {
+
+      if ((Scancode == ScancodeExtended) || ((Scancode & 0x80) != 0)) continue;
+
+      if (Counting == true) {
+
+        Counting = false;
+        DrawCountdown(CountdownRow, 0);
+
+      }
+
+      uint8 Previous = Selected;
+
+      if (Scancode == ScancodeEnter) {
+
+        Chosen = true;
+
+      } else if ((Scancode == ScancodeUp) && (Selected > 0)) {
+
+        Selected--;
+
+      } else if ((Scancode == ScancodeDown) && (Selected < (Count - 1))) {
+
+        Selected++;
+
+      }
+
+      if (Selected != Previous) {
+
+        DrawLine(MenuEntryRow + Previous, "  ", Entries[Previous].Name, 0x07);
+        DrawLine(MenuEntryRow + Selected, "  ", Entries[Selected].Name, 0x70);
+
+      }
+
+    }
+
+    // Update the countdown (only when the amount of seconds left changes), and stop once it runs out.
+
+    if ((Chosen != true) && (Counting == true)) {
+
+      uint32 Ticks = TimerTicks;
+
+      if (Ticks >= Deadline) {
+
+        Chosen = true;
+
+      } else {
+
+        uint16 Seconds = (((Deadline - Ticks) * 10) + TicksPerTenSeconds - 1) / TicksPerTenSeconds;
+
+        if (Seconds != Shown) {
+
+          Shown = Seconds;
+          DrawCountdown(CountdownRow, Seconds);
+
+        }
+
+      }
+
+    }
+
+    // Do some work in the background if there's any left, or wait for the next tick (or key) if there isn't.
+
+    if ((Chosen != true) && ((Idle == 0) || (Idle() != true))) {
+      WaitForInterrupt();
+    }
+
+  }
+
+  RestoreInterrupts();
+  InitializeTerminal(Terminal.Max_X, Terminal.Max_Y, Terminal.TabSize, Terminal.Framebuffer);
+
+  return Selected;
+
+}
@@ -0,0 +1,36 @@
+/* Ribeira | Written in 2022 by NunoLealF
+   To the extent possible under law, NunoLealF has waived all copyright and related or neighboring rights to this
+   software to the public domain worldwide. This software is distributed without any warranty.
+
+   You should have received a copy of the CC0 Public Domain Dedication along with this software.
+   If not, see <http://creativecommons.org/publicdomain/zero/1.0/>. */
+
+// WARNING: This is 16-bit C code. You should compile this, along with any other files from the second stage
+// bootloader, with the -m16 (or equivalent) flag.
+
+#ifndef _MENU_H_
+#define _MENU_H_
+
+// The amount of seconds the boot menu waits for before booting the default entry. This is set with the MENUTIMEOUT
+// variable in the makefile; if it's zero, the menu isn't shown at all.
+
+#ifndef MenuTimeout
+#define MenuTimeout     5
+#endif
+
+// Every boot entry can ask for up to MenuMaxModules modules from the module archive, and the boot menu can show
+// up to MenuMaxEntries entries (each one on its own line).
+
+#define MenuMaxModules  4
+#define MenuMaxEntries  16
+
+typedef struct _BootEntryStruct_ {
+
+  const char*             Name;
+  const char*             Modules[MenuMaxModules];
+
+} BootEntryStruct;
+
+uint8 BootMenu(const BootEntryStruct* Entries, uint8 Count, uint8 Default, uint16 Timeout, bool (*Idle)(void));
+
+#endif
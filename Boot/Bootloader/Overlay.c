@@ -0,0 +1,117 @@
+/* Ribeira | Written in 2022 by NunoLealF
+   To the extent possible under law, NunoLealF has waived all copyright and related or neighboring rights to this
+   software to the public domain worldwide. This software is distributed without any warranty.
+
+   You should have received a copy of the CC0 Public Domain Dedication along with this software.
+   If not, see <http://creativecommons.org/publicdomain/zero/1.0/>. */
+
+// WARNING: This is 16-bit C code. You should compile this, along with any other files from the second stage
+// bootloader, with the -m16 (or equivalent) flag.
+
+#include "Stdint.h"
+#include "Disk.h"
+#include "Overlay.h"
+
+/*  OverlayEntryStruct: This is a struct that defines an entry in the overlay table, which is generated by the linker
+    (in Bootloader.ld), and has one entry for every overlay.
+
+    uint32 Offset                                    - The offset of the overlay on the disk, in sectors, from
+                                                     OverlaySector.
+
+    uint32 Sectors                                   - The size of the overlay, in sectors.
+
+    Overlays let us keep code that most boots never run (like the memory test, or the code that only runs when the
+    probe cache is out of date) out of the core of the 2nd stage bootloader, which the bootsector has to load on
+    every boot. Every overlay runs from the same area of memory (the overlay window, from 4000h to 5FFFh, between the
+    module archive index and the stack), so only one of them can be loaded at a time, and an overlay can't call a
+    function from another overlay.
+
+*/
+
+typedef struct _OverlayEntryStruct_ {
+
+  uint32                  Offset;
+  uint32                  Sectors;
+
+} OverlayEntryStruct;
+
+extern const OverlayEntryStruct OverlayTable[];
+extern char OverlayWindow[];
+
+static uint8 CurrentOverlay = 0xFF;
+
+
+
+/*  LoadOverlay(): Loads an overlay into the overlay window, if it isn't already loaded.
+
+    Input:        uint8 Number                       - The number of the overlay you want to load, from Overlay.h
+                                                     (like OverlayMemtest).
+
+    Output:       bool                               - This returns true if the overlay is loaded, and false if it
+                                                     couldn't be read from the disk.
+
+    This function loads an overlay from the disk into the overlay window, which is where every overlay is linked to
+    run from. Functions that are marked with OverlayEntry() (see Overlay.h) call this on their own, so it only has
+    to be called beforehand if you want to handle an overlay that can't be loaded without crashing. If that overlay is
+    already loaded, then this doesn't do anything, so calling it again (or calling it in a loop) is cheap.
+
+    The overlay is read straight into the overlay window in one go, as it's stored on its own sectors on the disk.
+
+*/
+
+bool LoadOverlay(uint8 Number) {
+
+  if (Number == CurrentOverlay) {
+
+    return true;
+
+  } else if (Number >= OverlayCount) {
+
+    return false;
+
+  }
+
+  CurrentOverlay = 0xFF;
+
+  uint32 Lba = OverlaySector + OverlayTable[Number].Offset;
+
+  if (ReadSectors(Lba, OverlayTable[Number].Sectors, (uint32)OverlayWindow) != true) {
+
+    return false;
+
+  }
+
+  CurrentOverlay = Number;
+  return true;
+
+}
+
+
+
+/*  EnterOverlay: The second half of every stub from OverlayEntry().
+
+    Every stub pushes the address of the function it stands in for, and then the number of its overlay, before
+    jumping here. This calls LoadOverlay() with that number, and then returns to the function's address, which leaves
+    the stack (the stub's return address, and its arguments) just as it was when the stub was called. If the overlay
+    couldn't be loaded, it crashes with error 3 instead.
+
+    This is written in assembly, since it has to jump to the function without touching any of its arguments.
+
+*/
+
+__asm__ (
+  ".section .text.EnterOverlay, \"ax\" \n"
+
+  ".globl EnterOverlay \n"
+  "EnterOverlay: \n"
+  "  calll LoadOverlay \n"
+  "  addl $4, %esp \n"
+  "  testl %eax, %eax \n"
+  "  jnz 1f \n"
+  "  retl \n"
+  "1: \n"
+  "  pushl $3 \n"
+  "  calll Crash \n"
+
+  ".previous \n"
+);
@@ -0,0 +1,51 @@
+/* Ribeira | Written in 2022 by NunoLealF
+   To the extent possible under law, NunoLealF has waived all copyright and related or neighboring rights to this
+   software to the public domain worldwide. This software is distributed without any warranty.
+
+   You should have received a copy of the CC0 Public Domain Dedication along with this software.
+   If not, see <http://creativecommons.org/publicdomain/zero/1.0/>. */
+
+// WARNING: This is 16-bit C code. You should compile this, along with any other files from the second stage
+// bootloader, with the -m16 (or equivalent) flag.
+
+#ifndef _OVERLAY_H_
+#define _OVERLAY_H_
+
+// The overlays are stored from LBA 64 to 127, right after Boot.bin, and each of them is numbered in the same order as
+// in the overlay table in Bootloader.ld. Putting Overlay(Name) before a function moves it into that overlay.
+
+#define OverlaySector    64
+#define OverlaySectors   64
+
+#define OverlayMemtest   0
+#define OverlayProbe     1
+#define OverlayMenu      2
+#define OverlayLog       3
+#define OverlayCount     4
+
+// Overlay(Name) is for functions, and OverlayData(Name) is for constant data (like tables of strings) that's only used
+// by that overlay. They're kept in different sections, since gcc doesn't allow code and data in the same one.
+
+#define Overlay(Name)      __attribute__((section(".overlay." #Name), noinline))
+#define OverlayData(Name)  __attribute__((section(".overlay." #Name ".data")))
+
+// OverlayEntry(Name, Function) goes right before a (non-static) function from an overlay, and makes it safe to call
+// from anywhere. It renames the function itself to Overlay_Function, and adds a stub with its usual name to the core,
+// which loads the overlay (see EnterOverlay in Overlay.c) and then jumps to the function, with the same arguments.
+
+#define OverlayString(Value)             #Value
+#define OverlayNumberString(Number)      OverlayString(Number)
+
+#define OverlayEntry(Name, Function) \
+  __typeof__(Function) Function __asm__("Overlay_" #Function); \
+  __asm__ (".section .text.OverlayEntry." #Function ", \"ax\" \n" \
+           ".globl " #Function " \n" \
+           #Function ": \n" \
+           "  pushl $Overlay_" #Function " \n" \
+           "  pushl $" OverlayNumberString(Overlay##Name) " \n" \
+           "  jmp EnterOverlay \n" \
+           ".previous \n")
+
+bool LoadOverlay(uint8 Number);
+
+#endif
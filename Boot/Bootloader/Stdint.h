@@ -17,6 +17,8 @@ typedef signed short   int16;
 typedef unsigned short uint16;
 typedef signed long    int32;
 typedef unsigned long  uint32;
+typedef signed long long   int64;
+typedef unsigned long long uint64;
 typedef int            bool;
 
 #define int_max  0xFFFFFFF
@@ -0,0 +1,271 @@
+/* Ribeira | Written in 2022 by NunoLealF
+   To the extent possible under law, NunoLealF has waived all copyright and related or neighboring rights to this
+   software to the public domain worldwide. This software is distributed without any warranty.
+
+   You should have received a copy of the CC0 Public Domain Dedication along with this software.
+   If not, see <http://creativecommons.org/publicdomain/zero/1.0/>. */
+
+// WARNING: This is 16-bit C code. You should compile this, along with any other files from the second stage
+// bootloader, with the -m16 (or equivalent) flag.
+
+#include "Stdint.h"
+#include "Unreal.h"
+
+/*  UnrealGdt: The temporary GDT that's used to switch into unreal mode. The first entry is the null descriptor, and the
+    second one (UnrealDataSelector) is a data segment with a base of 0 and a limit of 4GiB (0xFFFFF, in 4KiB pages).
+
+    UnrealGdtDescriptor: The descriptor that's loaded with lgdt, which has the size (minus one) and the address of the
+    GDT. Since DS is always 0 here, the address of the GDT is the same as its linear address.
+
+    In real mode, every segment has a hidden limit that's usually 64KiB, so any address past FFFFh (like the
+    framebuffer at B8000h, or anything above 1MiB) would cause a general protection fault. Loading a segment in
+    protected mode changes that limit, and going back to real mode doesn't change it back, so after this, DS and ES
+    can reach the whole 4GiB address space with 32-bit offsets, while everything else (including BIOS calls) works
+    the same as before.
+
+*/
+
+static const uint64 UnrealGdt[2] = {
+
+  0x0000000000000000,
+  0x00CF92000000FFFF
+
+};
+
+static const GdtDescriptorStruct UnrealGdtDescriptor = {sizeof(UnrealGdt) - 1, (uint32)UnrealGdt};
+
+
+
+/*  Outb(), Inb(): Writes or reads a byte to/from an I/O port.
+
+    Input:        uint16 Port                        - The I/O port you want to write to or read from.
+
+    Input:        uint8 Value                        - (Outb only) The byte you want to write.
+
+    Output:       uint8                              - (Inb only) The byte that was read.
+
+    As these are static functions, they are not accessible outside of this file.
+
+*/
+
+static void Outb(uint16 Port, uint8 Value) {
+
+  __asm__ volatile("outb %0, %1" : : "a" (Value), "Nd" (Port));
+
+}
+
+static uint8 Inb(uint16 Port) {
+
+  uint8 Value;
+  __asm__ volatile("inb %1, %0" : "=a" (Value) : "Nd" (Port));
+
+  return Value;
+
+}
+
+
+
+/*  EnterUnrealMode(): Switches the CPU into unreal (flat real) mode.
+
+    (No inputs or outputs)
+
+    This function loads the temporary GDT, enables protected mode just long enough to load the flat data descriptor
+    into DS and ES (which sets their limits to 4GiB), and then goes back to real mode, setting DS and ES back to 0.
+    Interrupts are disabled while the CPU is in protected mode, since the IVT can't be used there, and then restored
+    to whatever they were before. CS and SS are never touched, so the code and the stack keep working as usual.
+
+    This must be called before anything uses an address past FFFFh. Loading a segment register in real mode only
+    changes its base, so the 4GiB limits survive ordinary BIOS calls and interrupts. They're only reset if something
+    switches to protected mode and back, which some BIOSes do for int 15h, ah 87h, and might do for disk reads (for
+    example, from USB drives). For that reason, ContinueModule() calls this again after every disk read, before it
+    copies anything above 1MiB. It only takes a few instructions, so this is cheap.
+
+*/
+
+void EnterUnrealMode(void) {
+
+  __asm__ volatile("pushfl \n"
+                   "cli \n"
+                   "lgdtl %0 \n"
+
+                   "movl %%cr0, %%eax \n"
+                   "orb $1, %%al \n"
+                   "movl %%eax, %%cr0 \n"
+                   "jmp 1f \n"
+                   "1: \n"
+
+                   "movw %1, %%bx \n"
+                   "movw %%bx, %%ds \n"
+                   "movw %%bx, %%es \n"
+
+                   "andb $0xFE, %%al \n"
+                   "movl %%eax, %%cr0 \n"
+                   "jmp 2f \n"
+                   "2: \n"
+
+                   "xorw %%bx, %%bx \n"
+                   "movw %%bx, %%ds \n"
+                   "movw %%bx, %%es \n"
+                   "popfl"
+
+                   : : "m" (UnrealGdtDescriptor), "i" (UnrealDataSelector) : "eax", "ebx", "cc", "memory");
+
+}
+
+
+
+/*  A20Enabled(): Checks whether the A20 line is enabled.
+
+    Output:       bool                               - This returns true if the A20 line is enabled, and false if
+                                                     it isn't.
+
+    This function checks if the A20 line is enabled, by writing different values to 000500h and 100500h in memory, and
+    checking if they alias each other. If they do, then the A20 line is disabled, and any memory above 1MiB would
+    wrap around to the start of memory.
+
+    Both memory locations are restored afterwards. This needs unreal mode, since 100500h is past the usual 64KiB limit.
+
+*/
+
+bool A20Enabled(void) {
+
+  volatile uint8* Low  = (volatile uint8*)0x000500;
+  volatile uint8* High = (volatile uint8*)0x100500;
+
+  uint8 LowValue  = *Low;
+  uint8 HighValue = *High;
+
+  *Low  = 0x00;
+  *High = 0xFF;
+
+  bool Result = (*Low == 0xFF) ? false : true;
+
+  *High = HighValue;
+  *Low  = LowValue;
+
+  return Result;
+
+}
+
+
+
+/*  WaitForA20(): Waits for the A20 line to be enabled.
+
+    Output:       bool                               - This returns true if the A20 line was enabled within A20Retries
+                                                     checks, and false if it wasn't.
+
+    As this is a static function, it is not accessible outside of this file.
+
+*/
+
+static bool WaitForA20(void) {
+
+  for (uint32 i = 0; i < A20Retries; i++) {
+    if (A20Enabled() == true) return true;
+  }
+
+  return false;
+
+}
+
+
+
+/*  EnableA20(): Enables the A20 line, if it isn't already.
+
+    Output:       bool                               - This returns true if the A20 line is enabled, and false if it
+                                                     couldn't be enabled.
+
+    This function first asks the BIOS to enable the A20 line (with int 15h, ax 2401h), and if that doesn't work, it
+    uses the 'fast A20' bit in the system control port (92h). Most systems (and emulators) already boot with it
+    enabled, in which case this doesn't do anything. Unreal mode must have been set up with EnterUnrealMode() first.
+
+*/
+
+bool EnableA20(void) {
+
+  if (A20Enabled() == true) return true;
+
+  // Ask the BIOS first, since it knows the best way to do this on its own system.
+
+  uint16 Ax = 0x2401;
+  __asm__ volatile("int $0x15" : "+a" (Ax) : : "cc", "memory");
+
+  if (WaitForA20() == true) return true;
+
+  // If that didn't work, try the system control port. Bit 0 resets the system, so make sure it's never set.
+
+  uint8 Value = Inb(0x92);
+
+  if ((Value & 0x02) == 0) {
+    Outb(0x92, (Value | 0x02) & 0xFE);
+  }
+
+  return WaitForA20();
+
+}
+
+
+
+/*  MemcpyFar(): Copies an area of memory to another memory location, anywhere in the first 4GiB.
+
+    Input:        uint32 DestinationAddress          - The linear address you want to copy to.
+
+    Input:        uint32 SourceAddress               - The linear address you want to copy from.
+
+    Input:        uint32 Size                        - How many bytes you want to copy.
+
+    Output:       uint32                             - The destination address.
+
+    This function does the same thing as Memcpy(), but with linear addresses, and it copies a dword at a time with
+    'addr32 rep movsl' (using ESI and EDI, instead of SI and DI), with the last few bytes copied one at a time. This
+    is much faster than Memcpy() for large copies, like moving a module from the disk buffer to above 1MiB.
+
+    The two areas must not overlap, and unreal mode must have been set up with EnterUnrealMode() first.
+
+*/
+
+uint32 MemcpyFar(uint32 DestinationAddress, uint32 SourceAddress, uint32 Size) {
+
+  uint32 Destination = DestinationAddress;
+  uint32 Source = SourceAddress;
+  uint32 Dwords = (Size / 4);
+  uint32 Bytes = (Size % 4);
+
+  __asm__ volatile("cld; addr32 rep movsl" : "+D" (Destination), "+S" (Source), "+c" (Dwords) : : "memory");
+  __asm__ volatile("addr32 rep movsb" : "+D" (Destination), "+S" (Source), "+c" (Bytes) : : "memory");
+
+  return DestinationAddress;
+
+}
+
+
+
+/*  MemsetFar(): Fills an area of memory with a value, anywhere in the first 4GiB.
+
+    Input:        uint32 Address                     - The linear address of the area you want to fill.
+
+    Input:        uint8 Value                        - The value you want to fill it with.
+
+    Input:        uint32 Size                        - How many bytes you want to fill.
+
+    Output:       uint32                             - The address of the area.
+
+    This function does the same thing as Memset(), but with a linear address, and it fills a dword at a time with
+    'addr32 rep stosl', with the last few bytes filled one at a time. Unreal mode must have been set up with
+    EnterUnrealMode() first.
+
+*/
+
+uint32 MemsetFar(uint32 Address, uint8 Value, uint32 Size) {
+
+  uint32 Destination = Address;
+  uint32 Pattern = Value * 0x01010101;
+  uint32 Dwords = (Size / 4);
+  uint32 Bytes = (Size % 4);
+
+  __asm__ volatile("cld; addr32 rep stosl" : "+D" (Destination), "+c" (Dwords) : "a" (Pattern) : "memory");
+  __asm__ volatile("addr32 rep stosb" : "+D" (Destination), "+c" (Bytes) : "a" (Pattern) : "memory");
+
+  return Address;
+
+}
@@ -0,0 +1,38 @@
+/* Ribeira | Written in 2022 by NunoLealF
+   To the extent possible under law, NunoLealF has waived all copyright and related or neighboring rights to this
+   software to the public domain worldwide. This software is distributed without any warranty.
+
+   You should have received a copy of the CC0 Public Domain Dedication along with this software.
+   If not, see <http://creativecommons.org/publicdomain/zero/1.0/>. */
+
+// WARNING: This is 16-bit C code. You should compile this, along with any other files from the second stage
+// bootloader, with the -m16 (or equivalent) flag.
+
+#ifndef _UNREAL_H_
+#define _UNREAL_H_
+
+// The temporary GDT only has a null descriptor and a flat 4GiB data descriptor, which is only ever loaded into DS
+// and ES while switching into unreal mode.
+
+#define UnrealDataSelector  0x08
+
+// How many times EnableA20() checks the A20 line after each method, since some systems take a while to enable it.
+
+#define A20Retries          1000
+
+typedef struct _GdtDescriptorStruct_ {
+
+  uint16                  Limit;
+  uint32                  Base;
+
+} __attribute__((packed)) GdtDescriptorStruct;
+
+void EnterUnrealMode(void);
+
+bool A20Enabled(void);
+bool EnableA20(void);
+
+uint32 MemcpyFar(uint32 DestinationAddress, uint32 SourceAddress, uint32 Size);
+uint32 MemsetFar(uint32 Address, uint8 Value, uint32 Size);
+
+#endif
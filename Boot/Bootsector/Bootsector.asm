@@ -9,6 +9,21 @@
 [BITS 16]
 
 
+; The makefile sets CoreSectors to the size of the core of the 2nd stage bootloader (in sectors), which is the only
+; part of it we have to load here; the rest of it (the overlays) is only loaded if and when it's needed.
+
+%ifndef CoreSectors
+  %define CoreSectors 47
+%endif
+
+; In benchmark builds (with BENCH=1 in the makefile), we save the TSC before and after loading the core, at 7C60h and
+; 7C68h (an unused part of the BPB), so that the 2nd stage bootloader can tell how long loading it took.
+
+%ifndef Benchmark
+  %define Benchmark 0
+%endif
+
+
 ; These two instructions jump over the area reserved for the BIOS Parameter Block, which is explained later on.
 ; The standard is to do a short jump 118 (76h) bytes forward, and add a nop instruction. This is also known as
 ; 'EB 76 90'. The jump should arrive at SetCS.
@@ -60,19 +75,25 @@ SetCS:
 ;
 ;   This label marks the start of the first-stage bootloader. In this environment, we are in 16-bit real mode,
 ;   with CS:IP set to 0000:7C00h, with DL set to the current drive number by our BIOS. All we'll do here is
-;   set up the stack at 7B00h in memory (where it has nearly 30KiB of space), and load the second stage bootloader,
-;   and if the latter fails, give out an error message.
+;   set up the stack at 7B00h in memory (where it has about 6.75KiB of space, down to 6000h), and load the second
+;   stage bootloader, and if the latter fails, give out an error message.
 ;
-;   The second stage bootloader, which is 48 sectors, or 24KiB long, will be loaded at 0x7E00 in memory, going
-;   up to 0xDDFF in RAM. Finally, the BootTable, which contains the information gathered by the second stage
-;   bootloader, is stored from 0xE000 to 0xFFFF, having roughly 8KiB of space.
+;   The second stage bootloader uses 1000h to 2FFFh as a disk buffer (DiskBuffer, in Disk.h), keeps the index of
+;   the module archive from 3000h to 3FFFh (ArchiveIndex, in Archive.h), and runs its overlays from 4000h to 5FFFh
+;   (OverlayWindow, in Bootloader.ld), so nothing else should go there.
+;
+;   The core of the second stage bootloader, which is CoreSectors long (at most 47 sectors, or 23.5KiB), will be
+;   loaded at 0x7E00 in memory, going up to 0xDBFF in RAM at most. Finally, the BootTable, which contains the
+;   information gathered by the second stage bootloader, is stored from 0xE000 to 0xFFFF, having roughly 8KiB of
+;   space. The 16 sectors after the second stage bootloader are reserved for storage, and aren't loaded here.
 ;
 ;   It's loaded in with the BIOS function int 13h ah 02h, which loads AL sectors from the disk at DL, the head at
 ;   DH, the cylinder at CH and the sector at CL, into the memory location in ES:BX. Keep in mind that the sector
 ;   number starts at 1, while the disk, head and cylinder numbers start at 0.
 ;
 ;   DL is preserved throughout the whole file. This is because our BIOS sets DL to the current drive number, which
-;   is the same drive number as the rest of our bootloader. For this reason, it's quite important.
+;   is the same drive number as the rest of our bootloader. For this reason, it's quite important. It's also saved
+;   at 0x7C40 (the drive number field of the FAT32 BPB), so that the second stage bootloader can find it.
 
 Start:
 
@@ -82,8 +103,17 @@ Start:
   mov ss, ax
   mov sp, 0x7B00
 
+  mov [0x7C40], dl
+
+%if Benchmark
+  rdtsc
+  mov [0x7C60], eax
+  mov [0x7C64], edx
+  mov dl, [0x7C40]
+%endif
+
   mov ah, 0x02
-  mov al, 0x30
+  mov al, CoreSectors
   mov bx, 0x7E00
   mov ch, 0x00
   mov cl, 0x02
@@ -92,6 +122,14 @@ Start:
   int 0x13
 
   jc DiskLoadFail
+
+%if Benchmark
+  rdtsc
+  mov [0x7C68], eax
+  mov [0x7C6C], edx
+  mov dl, [0x7C40]
+%endif
+
   jnc 0x7E00
 
 
@@ -0,0 +1,37 @@
+/* Ribeira | Written in 2022 by NunoLealF
+   To the extent possible under law, NunoLealF has waived all copyright and related or neighboring rights to this
+   software to the public domain worldwide. This software is distributed without any warranty.
+
+   You should have received a copy of the CC0 Public Domain Dedication along with this software.
+   If not, see <http://creativecommons.org/publicdomain/zero/1.0/>. */
+
+// WARNING: Unlike the rest of the bootloader, this is regular C code that runs on the machine you're building the
+// bootloader on (the 'host'). You should compile this with your system's C compiler, not the cross compiler.
+
+// This is a replacement for Bootloader/Stdint.h, which is used when building parts of the 2nd stage bootloader for
+// the host (see Tests/Tests.c). On most 64-bit hosts, long is 64 bits wide, so the types in Bootloader/Stdint.h
+// would be the wrong size; instead, these are taken from the host's <stdint.h>. The makefile force-includes this
+// file (with -include), and as it uses the same include guard, Bootloader/Stdint.h is then skipped.
+
+#ifndef _STDINT_H_
+#define _STDINT_H_
+
+#include <stdint.h>
+
+typedef int8_t         int8;
+typedef uint8_t        uint8;
+typedef int16_t        int16;
+typedef uint16_t       uint16;
+typedef int32_t        int32;
+typedef uint32_t       uint32;
+typedef int64_t        int64;
+typedef uint64_t       uint64;
+typedef int            bool;
+
+#define int_max  0xFFFFFFF
+#define uint_max 0xFFFFFFFF
+
+#define true     0
+#define false    1
+
+#endif
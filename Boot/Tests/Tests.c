@@ -0,0 +1,558 @@
+/* Ribeira | Written in 2022 by NunoLealF
+   To the extent possible under law, NunoLealF has waived all copyright and related or neighboring rights to this
+   software to the public domain worldwide. This software is distributed without any warranty.
+
+   You should have received a copy of the CC0 Public Domain Dedication along with this software.
+   If not, see <http://creativecommons.org/publicdomain/zero/1.0/>. */
+
+// WARNING: Unlike the rest of the bootloader, this is regular C code that runs on the machine you're building the
+// bootloader on (the 'host'). You should compile this with your system's C compiler, not the cross compiler.
+
+// This is a test harness for Bootloader/Memory.c and Bootloader/Graphics.c, which the makefile builds for the host
+// (with Tests/Stdint.h instead of Bootloader/Stdint.h). It checks them against the C library (or a simple reference
+// version) with random inputs, and it can also measure how fast they are, so that any changes to them can be tested
+// on a normal system before being tried out on real hardware. This needs an x86 Linux (or similar) host.
+
+#define _GNU_SOURCE
+
+#include "Stdint.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+
+#include "../Bootloader/Memory.h"
+#include "../Bootloader/Graphics.h"
+
+#define BufferSize    8192
+#define Iterations    20000
+
+static uint64_t Seed = 0x5269626569726121;
+static unsigned long Failures = 0;
+
+
+
+/*  Random(): Returns a pseudo-random number (with xorshift64).
+
+    Output:       uint64_t                           - The next pseudo-random number. Every run with the same seed
+                                                     gives the same numbers, so any failure can be reproduced.
+
+*/
+
+static uint64_t Random(void) {
+
+  Seed ^= Seed << 13;
+  Seed ^= Seed >> 7;
+  Seed ^= Seed << 17;
+
+  return Seed;
+
+}
+
+
+
+/*  Fill(): Fills an area of memory with pseudo-random bytes.
+
+    Output:       uint8_t* Buffer                    - The area of memory you want to fill.
+
+    Input:        size_t Size                        - The size of that area, in bytes.
+
+*/
+
+static void Fill(uint8_t* Buffer, size_t Size) {
+
+  for (size_t i = 0; i < Size; i++) {
+
+    Buffer[i] = (uint8_t)Random();
+
+  }
+
+}
+
+
+
+/*  Check(): Records the result of a test.
+
+    Input:        int Passed                         - Whether the test passed (non-zero) or not (zero).
+
+    Input:        const char* Name                   - The name of the function being tested.
+
+    Input:        size_t Size, Offset1, Offset2      - The inputs of the test, so that it can be reproduced.
+
+    Only the first few failures of every run are printed, but all of them are counted.
+
+*/
+
+static void Check(int Passed, const char* Name, size_t Size, size_t Offset1, size_t Offset2) {
+
+  if (Passed) return;
+
+  if (Failures++ < 10) {
+
+    printf("  FAIL: %s (size %zu, offsets %zu and %zu)\n", Name, Size, Offset1, Offset2);
+
+  }
+
+}
+
+
+
+/*  Sign(): Returns the sign of a number (-1, 0 or 1).
+
+*/
+
+static int Sign(int Value) {
+
+  return (Value > 0) - (Value < 0);
+
+}
+
+
+
+/*  TestMemory(): Checks Memset(), Memcpy(), Memmove() and Memcmp() against the C library.
+
+    Every test uses two identical buffers, one for our function and one for the C library's function, with random
+    sizes and offsets (so every alignment gets tested). The whole buffer is compared afterwards, not just the part
+    that was written to, so that writing out of bounds is also caught.
+
+*/
+
+static void TestMemory(void) {
+
+  static uint8_t Ours[BufferSize], Theirs[BufferSize], Source[BufferSize];
+
+  for (int i = 0; i < Iterations; i++) {
+
+    size_t Size = Random() % ((i % 4 == 0) ? 4096 : 64);
+    size_t Offset1 = Random() % 64;
+    size_t Offset2 = Random() % 64;
+    uint8_t Value = (uint8_t)Random();
+
+    // Memset()
+
+    Fill(Ours, BufferSize);
+    memcpy(Theirs, Ours, BufferSize);
+
+    Memset(Ours + Offset1, Value, Size);
+    memset(Theirs + Offset1, Value, Size);
+    Check(memcmp(Ours, Theirs, BufferSize) == 0, "Memset", Size, Offset1, 0);
+
+    // Memcpy()
+
+    Fill(Source, BufferSize);
+
+    Memcpy(Ours + Offset1, Source + Offset2, Size);
+    memcpy(Theirs + Offset1, Source + Offset2, Size);
+    Check(memcmp(Ours, Theirs, BufferSize) == 0, "Memcpy", Size, Offset1, Offset2);
+
+    // Memmove(), with areas that (usually) overlap, in both directions.
+
+    size_t Source1 = Random() % (BufferSize - Size);
+    size_t Destination1 = Random() % (BufferSize - Size);
+
+    if (Random() % 2) {
+
+      Destination1 = Source1 + (Random() % 16) - 8;
+      if (Destination1 > (BufferSize - Size)) Destination1 = Source1;
+
+    }
+
+    Memmove(Ours + Destination1, Ours + Source1, Size);
+    memmove(Theirs + Destination1, Theirs + Source1, Size);
+    Check(memcmp(Ours, Theirs, BufferSize) == 0, "Memmove", Size, Destination1, Source1);
+
+    // Memcmp(), with either identical areas, or areas that differ in one random byte.
+
+    memcpy(Theirs, Ours, BufferSize);
+
+    if ((Size != 0) && (Random() % 4 != 0)) {
+
+      Theirs[Offset2 + (Random() % Size)] = (uint8_t)Random();
+
+    }
+
+    int Expected = Sign(memcmp(Ours + Offset2, Theirs + Offset2, Size));
+    Check(Sign(Memcmp(Ours + Offset2, Theirs + Offset2, Size)) == Expected, "Memcmp", Size, Offset2, Offset2);
+
+  }
+
+}
+
+
+
+/*  TestChecksum(): Checks Checksum() against a simple (but slow) version of Adler-32.
+
+    The sizes go up to 20000 bytes, so that Checksum() has to reduce its sums more than once.
+
+*/
+
+static void TestChecksum(void) {
+
+  static uint8_t Buffer[20000];
+
+  for (int i = 0; i < 500; i++) {
+
+    size_t Size = Random() % sizeof(Buffer);
+    Fill(Buffer, Size);
+
+    if (i % 8 == 0) memset(Buffer, 0xFF, Size);
+
+    uint32_t A = 1;
+    uint32_t B = 0;
+
+    for (size_t j = 0; j < Size; j++) {
+
+      A = (A + Buffer[j]) % 65521;
+      B = (B + A) % 65521;
+
+    }
+
+    Check(Checksum(Buffer, Size) == ((B << 16) | A), "Checksum", Size, 0, 0);
+
+  }
+
+}
+
+
+
+/*  TestStrings(): Checks Strlen() against strlen(), and Itoa() against snprintf() (or a reference version).
+
+*/
+
+static void TestStrings(void) {
+
+  static char String[1024];
+
+  for (int i = 0; i < Iterations; i++) {
+
+    size_t Length = Random() % sizeof(String);
+
+    for (size_t j = 0; j < Length; j++) String[j] = (char)((Random() % 255) + 1);
+    String[Length] = '\0';
+
+    Check(Strlen(String) == strlen(String), "Strlen", Length, 0, 0);
+
+  }
+
+  for (int i = 0; i < Iterations; i++) {
+
+    unsigned long Value = (unsigned long)(Random() >> (Random() % 64));
+    unsigned short Base = (unsigned short)(Random() % 40);
+
+    if (i < 40) Value = (i % 2 == 0) ? 0 : (unsigned long)-1;
+
+    char Ours[72];
+    char Theirs[72] = "";
+
+    // A digit at a time, from the least significant digit upwards, for any base from 2 to 36.
+
+    if ((Base >= 2) && (Base <= 36)) {
+
+      char Reverse[72];
+      unsigned long Remaining = Value;
+      int Digits = 0;
+
+      do {
+
+        Reverse[Digits++] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ"[Remaining % Base];
+        Remaining /= Base;
+
+      } while (Remaining > 0);
+
+      for (int j = 0; j < Digits; j++) Theirs[j] = Reverse[Digits - 1 - j];
+      Theirs[Digits] = '\0';
+
+    }
+
+    if (Base == 8) snprintf(Theirs, sizeof(Theirs), "%lo", Value);
+    if (Base == 10) snprintf(Theirs, sizeof(Theirs), "%lu", Value);
+    if (Base == 16) snprintf(Theirs, sizeof(Theirs), "%lX", Value);
+
+    Itoa(Value, Ours, Base);
+    Check(strcmp(Ours, Theirs) == 0, "Itoa", Base, 0, 0);
+
+  }
+
+}
+
+
+
+/*  TestTerminal(): Checks Putchar(), Print() and Scroll() against a reference terminal.
+
+    The framebuffer has to be under 4GiB, since the Terminal struct only has a 32-bit address for it, so it's mapped
+    with MAP_32BIT. It's also surrounded by guard areas, so that writing outside of it is caught. The reference
+    terminal is a plain 80x25 array, which wraps lines and scrolls the same way the real terminal should.
+
+*/
+
+static void TestTerminal(uint8_t* Area) {
+
+  enum {Columns = 80, Rows = 25, Cells = (Columns * Rows), Guard = 4096};
+
+  uint16_t* Framebuffer = (uint16_t*)(Area + Guard);
+  static uint16_t Reference[Cells];
+
+  for (int i = 0; i < 200; i++) {
+
+    memset(Area, 0xA5, Guard + (Cells * 2) + Guard);
+    memset(Reference, 0, sizeof(Reference));
+
+    InitializeTerminal(Columns, Rows, 4, (uint32)(uintptr_t)Framebuffer);
+
+    int X = 0;
+    int Y = 0;
+    size_t Length = Random() % 4000;
+
+    for (size_t j = 0; j < Length; j++) {
+
+      // Mostly printable characters, with the occasional newline, carriage return or tab.
+
+      uint64_t Kind = Random() % 64;
+      char Character = (char)(' ' + (Random() % 95));
+      uint8_t Color = (uint8_t)Random();
+
+      if (Kind == 0) Character = '\n';
+      if (Kind == 1) Character = '\r';
+      if (Kind == 2) Character = '\t';
+
+      Putchar(Character, Color);
+
+      if ((Character == '\n') || (Character == '\t') || ((Character != '\r') && (X >= Columns))) {
+
+        if (Character == '\t') X += 4 - (X % 4);
+
+        if ((Character == '\n') || (X >= Columns)) {
+
+          if (Character != '\n') X = 0;
+          Y++;
+
+        }
+
+        if (Y >= Rows) {
+
+          memmove(Reference, Reference + Columns, (Cells - Columns) * 2);
+          for (int k = 0; k < Columns; k++) Reference[Cells - Columns + k] = ' ';
+          Y = Rows - 1;
+
+        }
+
+      }
+
+      if (Character == '\r') {
+
+        X = 0;
+
+      } else if ((Character != '\n') && (Character != '\t')) {
+
+        Reference[(Y * Columns) + X] = (uint8_t)Character | (Color << 8);
+        X++;
+
+      }
+
+    }
+
+    int Guarded = 1;
+
+    for (int k = 0; k < Guard; k++) {
+
+      if ((Area[k] != 0xA5) || (Area[Guard + (Cells * 2) + k] != 0xA5)) Guarded = 0;
+
+    }
+
+    Check(Guarded, "Putchar (wrote outside of the framebuffer)", Length, 0, 0);
+    Check(memcmp(Framebuffer, Reference, sizeof(Reference)) == 0, "Putchar", Length, 0, 0);
+
+  }
+
+  // Print() should give the same result as calling Putchar() for every character.
+
+  InitializeTerminal(Columns, Rows, 4, (uint32)(uintptr_t)Framebuffer);
+  Print("Ribeira\n\r\tbootloader", 0x0F);
+  memcpy(Reference, Framebuffer, sizeof(Reference));
+
+  InitializeTerminal(Columns, Rows, 4, (uint32)(uintptr_t)Framebuffer);
+  const char* String = "Ribeira\n\r\tbootloader";
+  for (size_t j = 0; j < strlen(String); j++) Putchar(String[j], 0x0F);
+
+  Check(memcmp(Framebuffer, Reference, sizeof(Reference)) == 0, "Print", strlen(String), 0, 0);
+
+}
+
+
+
+/*  Seconds(): Returns the current time, in seconds, from a monotonic clock.
+
+*/
+
+static double Seconds(void) {
+
+  struct timespec Time;
+  clock_gettime(CLOCK_MONOTONIC, &Time);
+
+  return Time.tv_sec + (Time.tv_nsec / 1e9);
+
+}
+
+
+
+/*  Benchmark(): Measures the throughput of the memory functions, for a few sizes and alignments.
+
+    Every function is run on the same data over and over again, for at least 50ms, and its throughput (in MB/s) is
+    printed, along with the C library's throughput for comparison. Keep in mind that the makefile builds Memory.c
+    with the same flags as the real bootloader (so, without optimizations), and that the host's cache and CPU are
+    nothing like the ones the bootloader will run on, so these numbers are only useful for comparing changes.
+
+*/
+
+static void Benchmark(uint8_t* Area) {
+
+  static const size_t Sizes[] = {16, 256, 4096, 65536};
+  static const size_t Alignments[][2] = {{0, 0}, {1, 0}, {0, 3}, {7, 5}};
+
+  static uint8_t Source[65536 + 64], Destination[65536 + 64];
+  const char* Names[] = {"Memset", "Memcpy", "Memmove", "Memcmp"};
+
+  Fill(Source, sizeof(Source));
+  memcpy(Destination, Source, sizeof(Destination));
+
+  printf("%-8s %8s %6s %12s %12s\n", "Function", "Size", "Align", "Ours (MB/s)", "libc (MB/s)");
+
+  for (int Function = 0; Function < 4; Function++) {
+
+    for (size_t i = 0; i < (sizeof(Sizes) / sizeof(Sizes[0])); i++) {
+
+      for (size_t j = 0; j < (sizeof(Alignments) / sizeof(Alignments[0])); j++) {
+
+        uint8_t* To = Destination + Alignments[j][0];
+        uint8_t* From = Source + Alignments[j][1];
+        size_t Size = Sizes[i];
+        double Throughput[2];
+
+        for (int Libc = 0; Libc < 2; Libc++) {
+
+          // Memcmp() is always given identical areas, so that it has to go through every byte.
+
+          if (Function == 3) memcpy(To, From, Size);
+
+          volatile int Result = 0;
+          unsigned long Runs = 0;
+          double Start = Seconds();
+          double Elapsed;
+
+          do {
+
+            for (int k = 0; k < 16; k++) {
+
+              switch (Function) {
+
+                case 0: (Libc ? memset(To, k, Size) : Memset(To, k, Size)); break;
+                case 1: (Libc ? memcpy(To, From, Size) : Memcpy(To, From, Size)); break;
+                case 2: (Libc ? memmove(To, From, Size) : Memmove(To, From, Size)); break;
+                case 3: Result += (Libc ? memcmp(To, From, Size) : Memcmp(To, From, Size)); break;
+
+              }
+
+            }
+
+            Runs += 16;
+            Elapsed = Seconds() - Start;
+
+          } while (Elapsed < 0.05);
+
+          Throughput[Libc] = ((double)Runs * Size) / (Elapsed * 1e6);
+          (void)Result;
+
+        }
+
+        printf("%-8s %8zu %3zu/%-2zu %12.1f %12.1f\n", Names[Function], Size, Alignments[j][0], Alignments[j][1],
+               Throughput[0], Throughput[1]);
+
+      }
+
+    }
+
+  }
+
+  // Finally, measure how fast Print() is, with enough lines that the terminal has to scroll on almost every one.
+
+  uint16_t* Framebuffer = (uint16_t*)(Area + 4096);
+  InitializeTerminal(80, 25, 4, (uint32)(uintptr_t)Framebuffer);
+
+  const char* Line = "The quick brown fox jumps over the lazy dog, and then it does that again.\n\r";
+  unsigned long Lines = 0;
+  double Start = Seconds();
+  double Elapsed;
+
+  do {
+
+    Print(Line, 0x0F);
+    Lines++;
+    Elapsed = Seconds() - Start;
+
+  } while (Elapsed < 0.1);
+
+  printf("%-8s %8zu %6s %12.1f %12s\n", "Print", strlen(Line), "-", (Lines * strlen(Line)) / (Elapsed * 1e6), "-");
+
+}
+
+
+
+/*  main(): Runs every test, or the benchmarks.
+
+    Usage:        Tests [Seed]
+                  Tests bench
+
+    This program runs every test with the given seed (or the default one), and prints out how many of them failed.
+    It returns 0 if every test passed, and 1 if any of them failed.
+
+*/
+
+int main(int argc, char** argv) {
+
+  // The framebuffer (and its guard areas) has to be under 4GiB, see TestTerminal().
+
+  uint8_t* Area = mmap(NULL, 16384, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+
+  if ((Area == MAP_FAILED) || ((uintptr_t)Area > 0xFFFFC000)) {
+
+    fprintf(stderr, "Tests: Couldn't map a framebuffer under 4GiB.\n");
+    return 1;
+
+  }
+
+  if ((argc > 1) && (strcmp(argv[1], "bench") == 0)) {
+
+    Benchmark(Area);
+    return 0;
+
+  }
+
+  if (argc > 1) Seed = strtoull(argv[1], NULL, 0);
+  if (Seed == 0) Seed = 1;
+
+  printf("Running tests (seed %llu).\n", (unsigned long long)Seed);
+
+  const struct {const char* Name; void (*Function)(void);} Tests[] = {
+    {"Memset, Memcpy, Memmove, Memcmp", TestMemory},
+    {"Checksum", TestChecksum},
+    {"Strlen, Itoa", TestStrings}
+  };
+
+  for (size_t i = 0; i < (sizeof(Tests) / sizeof(Tests[0])); i++) {
+
+    unsigned long Before = Failures;
+    Tests[i].Function();
+    printf("%s %s\n", (Failures == Before) ? "PASS" : "FAIL", Tests[i].Name);
+
+  }
+
+  unsigned long Before = Failures;
+  TestTerminal(Area);
+  printf("%s %s\n", (Failures == Before) ? "PASS" : "FAIL", "Putchar, Print, Scroll");
+
+  printf("%lu failure(s).\n", Failures);
+  return (Failures == 0) ? 0 : 1;
+
+}
@@ -0,0 +1,158 @@
+#!/bin/sh
+
+# Ribeira | Written in 2022 by NunoLealF
+# To the extent possible under law, NunoLealF has waived all copyright and related or neighboring rights to this
+# software to the public domain worldwide. This software is distributed without any warranty.
+#
+# You should have received a copy of the CC0 Public Domain Dedication along with this software.
+# If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+
+# This script boots a benchmark build of Boot.bin (see Bootloader/Bench.h) headless in Qemu, under a few different
+# configurations, and collects the timings that the 2nd stage bootloader sends over the serial port. It's normally
+# run with 'make bench', which builds Boot.bin with BENCH=1 first.
+#
+# Usage: Tools/Bench.sh <Boot.bin> <Results> [Baseline]
+#
+# Every configuration is booted twice from a fresh copy of the image; once with an empty probe cache ('cold'), and
+# once with the cache that the first boot left behind ('warm'). The results are written to <Results>, with one line
+# for every phase, like 'disk-32M-pentium2 cold e820 1234567' (the last field is in TSC cycles). If a baseline (a
+# results file from an earlier run) is given, any phase that's more than TOLERANCE percent slower than it is
+# reported as a regression, and the script fails. It also fails straight away if the baseline doesn't exist, so a
+# regression run can never pass without comparing anything.
+#
+# You can set QEMU (qemu-system-i386 by default), TOLERANCE (25 by default) and TIMEOUT (in seconds, 60 by default)
+# in the environment. CD configurations are skipped if there's no xorriso, genisoimage or mkisofs.
+
+Image="$1"
+Results="$2"
+Baseline="$3"
+
+QEMU="${QEMU:-qemu-system-i386}"
+TOLERANCE="${TOLERANCE:-25}"
+TIMEOUT="${TIMEOUT:-60}"
+
+if [ -z "$Image" ] || [ -z "$Results" ]; then
+
+  echo "Usage: $0 <Boot.bin> <Results> [Baseline]" >&2
+  exit 1
+
+fi
+
+if [ -n "$Baseline" ] && [ ! -f "$Baseline" ]; then
+
+  echo "There's no baseline at $Baseline to compare against. Run 'make benchbaseline' to make one first." >&2
+  exit 1
+
+fi
+
+# The configurations we boot under; a name, the type of media ('disk' or 'cd') and the arguments for Qemu. Keep
+# the names stable, since they're what results are compared by.
+
+Configs="disk-32M-pentium2   disk -cpu pentium2 -m 32
+disk-128M-pentium3  disk -cpu pentium3 -m 128
+disk-512M-qemu32    disk -cpu qemu32 -m 512
+disk-2G-core2duo    disk -cpu core2duo -m 2048
+cd-128M-pentium3    cd   -cpu pentium3 -m 128"
+
+# The 2nd stage bootloader writes BenchPassed (10h) to the isa-debug-exit device when it's done, which Qemu turns
+# into an exit status of 21h (33).
+
+Passed=33
+
+Work=$(mktemp -d)
+trap 'rm -rf "$Work"' EXIT
+
+IsoTool=""
+for Tool in xorriso genisoimage mkisofs; do
+
+  if command -v "$Tool" > /dev/null 2>&1; then IsoTool="$Tool"; break; fi
+
+done
+
+: > "$Results"
+Failed=0
+
+echo "$Configs" | while read -r Name Media Arguments; do
+
+  # Make a fresh copy of the image, so that the first boot always starts with an empty probe cache. CDs use El
+  # Torito floppy emulation, so the image has to be padded to exactly 1.44MB first.
+
+  cp "$Image" "$Work/Disk.bin"
+
+  if [ "$Media" = "cd" ]; then
+
+    if [ -z "$IsoTool" ] || [ "$(wc -c < "$Image")" -gt 1474560 ]; then
+
+      echo "Skipping $Name (can't make a CD image)."
+      continue
+
+    fi
+
+    mkdir -p "$Work/Iso"
+    dd if=/dev/zero of="$Work/Iso/Boot.img" bs=512 count=2880 status=none
+    dd if="$Image" of="$Work/Iso/Boot.img" conv=notrunc status=none
+
+    if [ "$IsoTool" = "xorriso" ]; then Mkisofs="xorriso -as mkisofs"; else Mkisofs="$IsoTool"; fi
+    $Mkisofs -quiet -b Boot.img -o "$Work/Boot.iso" "$Work/Iso" || continue
+
+    Drive="-cdrom $Work/Boot.iso -boot d"
+
+  else
+
+    Drive="-drive file=$Work/Disk.bin,format=raw"
+
+  fi
+
+  for Run in cold warm; do
+
+    : > "$Work/Serial.txt"
+
+    timeout "$TIMEOUT" $QEMU $Arguments $Drive -display none -monitor none -no-reboot \
+      -serial "file:$Work/Serial.txt" -device isa-debug-exit,iobase=0xf4,iosize=0x04
+
+    Status=$?
+
+    if [ "$Status" -ne "$Passed" ] || ! grep -q '^BENCH total ' "$Work/Serial.txt"; then
+
+      echo "$Name ($Run): failed (exit status $Status)." >&2
+      grep '^BENCH crash ' "$Work/Serial.txt" >&2
+      echo "$Name $Run failed 0" >> "$Results"
+      continue
+
+    fi
+
+    grep '^BENCH ' "$Work/Serial.txt" | tr -d '\r' | while read -r Tag Phase Cycles; do
+
+      echo "$Name $Run $Phase $(printf '%d' "0x$Cycles")" >> "$Results"
+
+    done
+
+  done
+
+done
+
+cat "$Results"
+
+if grep -q ' failed ' "$Results"; then Failed=1; fi
+
+# Compare the results against the baseline, phase by phase. Phases that are zero in the baseline (like e820 on a
+# warm boot) are skipped, since there's nothing to compare them with.
+
+if [ -n "$Baseline" ]; then
+
+  awk -v Tolerance="$TOLERANCE" '
+    NR == FNR { Base[$1 " " $2 " " $3] = $4; next }
+    (($1 " " $2 " " $3) in Base) && (Base[$1 " " $2 " " $3] > 0) {
+      Key = $1 " " $2 " " $3
+      Change = (($4 - Base[Key]) * 100) / Base[Key]
+      if (Change > Tolerance) {
+        printf("Regression: %s is %.1f%% slower (%d -> %d cycles).\n", Key, Change, Base[Key], $4)
+        Slower = 1
+      }
+    }
+    END { exit Slower }
+  ' "$Baseline" "$Results" || Failed=1
+
+fi
+
+exit $Failed
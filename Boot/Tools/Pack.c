@@ -0,0 +1,298 @@
+/* Ribeira | Written in 2022 by NunoLealF
+   To the extent possible under law, NunoLealF has waived all copyright and related or neighboring rights to this
+   software to the public domain worldwide. This software is distributed without any warranty.
+
+   You should have received a copy of the CC0 Public Domain Dedication along with this software.
+   If not, see <http://creativecommons.org/publicdomain/zero/1.0/>. */
+
+// WARNING: Unlike the rest of the bootloader, this is regular C code that runs on the machine you're building the
+// bootloader on (the 'host'). You should compile this with your system's C compiler, not the cross compiler.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// These must be the same as the definitions in Bootloader/Archive.h.
+
+#define ArchiveSignature      0x52414252
+#define ArchiveVersion        1
+#define ArchiveMaxEntries     64
+
+#define CompressionNone       0
+
+/*  ArchiveEntryStruct, ArchiveHeaderStruct: These are the same as the structs in Bootloader/Archive.h (and are
+    described in Bootloader/Archive.c), except that they use the standard integer types, as this runs on the host.
+
+    Every field is written in little-endian order, so you should only run this on a little-endian host (like x86).
+
+*/
+
+typedef struct _ArchiveEntryStruct_ {
+
+  char                    Name[32];
+  uint32_t                Offset;
+  uint32_t                Length;
+  uint32_t                Checksum;
+  uint16_t                Compression;
+  uint16_t                Reserved;
+
+} __attribute__((packed)) ArchiveEntryStruct;
+
+typedef struct _ArchiveHeaderStruct_ {
+
+  uint32_t                Signature;
+  uint16_t                Version;
+  uint16_t                Count;
+  uint32_t                Sectors;
+  uint32_t                IndexChecksum;
+
+} __attribute__((packed)) ArchiveHeaderStruct;
+
+typedef struct _ModuleFileStruct_ {
+
+  ArchiveEntryStruct      Entry;
+  unsigned char*          Data;
+
+} ModuleFileStruct;
+
+
+
+/*  Checksum(): Calculates an Adler-32 checksum. This must be the same as Checksum() in Bootloader/Memory.c.
+
+    Input:        const void* Address                - The area of memory you want to calculate a checksum of.
+
+    Input:        size_t Size                        - The size of that area, in bytes.
+
+    Output:       uint32_t                           - The checksum of that area of memory.
+
+*/
+
+static uint32_t Checksum(const void* Address, size_t Size) {
+
+  uint32_t A = 1;
+  uint32_t B = 0;
+
+  for (size_t i = 0; i < Size; i++) {
+
+    A = (A + ((const unsigned char*)Address)[i]) % 65521;
+    B = (B + A) % 65521;
+
+  }
+
+  return (B << 16) | A;
+
+}
+
+
+
+/*  CompareModules(): Compares two modules by name, for qsort().
+
+    Input:        const void* First, Second          - The two ModuleFileStructs you want to compare.
+
+    Output:       int                                - The result of comparing their names as unsigned bytes, which is
+                                                     the same order that the bootloader's binary search expects.
+
+*/
+
+static int CompareModules(const void* First, const void* Second) {
+
+  return strncmp(((const ModuleFileStruct*)First)->Entry.Name, ((const ModuleFileStruct*)Second)->Entry.Name, 32);
+
+}
+
+
+
+/*  ModuleName(): Works out the name of a module from its path.
+
+    Input:        const char* Path                   - The path of the file, like "Modules/Kernel.elf".
+
+    Output:       char* Name                         - The buffer (of 32 bytes) to write the name to, like "Kernel".
+
+    Output:       int                                - This returns 0 if it worked, or -1 if the name is too long.
+
+    This function removes any directories and the extension from a path, which gives us the name of the module.
+
+*/
+
+static int ModuleName(const char* Path, char* Name) {
+
+  const char* Start = strrchr(Path, '/');
+  Start = (Start == NULL) ? Path : (Start + 1);
+
+  const char* End = strchr(Start, '.');
+  size_t Length = (End == NULL) ? strlen(Start) : (size_t)(End - Start);
+
+  if ((Length == 0) || (Length > 31)) return -1;
+
+  memset(Name, 0, 32);
+  memcpy(Name, Start, Length);
+
+  return 0;
+
+}
+
+
+
+/*  main(): Packs a number of files into a module archive.
+
+    Usage:        Pack <Output> [Module...]
+
+    This program reads every module given to it, sorts them by name, and writes a module archive to Output. The archive
+    starts with a header and an index (which has the name, offset, length, checksum and compression of every module),
+    and every module after that starts on a new sector, so that the bootloader can read it straight from the disk.
+
+    An archive with no modules is still valid, so that the bootloader can tell 'no modules' apart from 'no archive'.
+
+*/
+
+int main(int argc, char** argv) {
+
+  if (argc < 2) {
+
+    fprintf(stderr, "Usage: %s <Output> [Module...]\n", argv[0]);
+    return 1;
+
+  }
+
+  int Count = argc - 2;
+
+  if (Count > ArchiveMaxEntries) {
+
+    fprintf(stderr, "Pack: Too many modules (%d), the most the bootloader supports is %d.\n", Count, ArchiveMaxEntries);
+    return 1;
+
+  }
+
+  ModuleFileStruct* Modules = calloc((Count > 0) ? Count : 1, sizeof(ModuleFileStruct));
+
+  // Read in every module, and fill out everything in its entry other than the offset.
+
+  for (int i = 0; i < Count; i++) {
+
+    const char* Path = argv[i + 2];
+
+    if (ModuleName(Path, Modules[i].Entry.Name) != 0) {
+
+      fprintf(stderr, "Pack: The name of '%s' must be between 1 and 31 characters long.\n", Path);
+      return 1;
+
+    }
+
+    FILE* File = fopen(Path, "rb");
+
+    if (File == NULL) {
+
+      fprintf(stderr, "Pack: Couldn't open '%s'.\n", Path);
+      return 1;
+
+    }
+
+    fseek(File, 0, SEEK_END);
+    long Length = ftell(File);
+    fseek(File, 0, SEEK_SET);
+
+    Modules[i].Data = malloc((Length > 0) ? Length : 1);
+
+    if ((Length < 0) || (fread(Modules[i].Data, 1, Length, File) != (size_t)Length)) {
+
+      fprintf(stderr, "Pack: Couldn't read '%s'.\n", Path);
+      return 1;
+
+    }
+
+    fclose(File);
+
+    Modules[i].Entry.Length = (uint32_t)Length;
+    Modules[i].Entry.Checksum = Checksum(Modules[i].Data, Length);
+    Modules[i].Entry.Compression = CompressionNone;
+
+  }
+
+  // Sort the modules by name (which the bootloader relies on), and make sure there aren't any duplicates.
+
+  qsort(Modules, Count, sizeof(ModuleFileStruct), CompareModules);
+
+  for (int i = 1; i < Count; i++) {
+
+    if (CompareModules(&Modules[i - 1], &Modules[i]) == 0) {
+
+      fprintf(stderr, "Pack: There's more than one module named '%s'.\n", Modules[i].Entry.Name);
+      return 1;
+
+    }
+
+  }
+
+  // Work out where every module goes; the first one starts on the sector after the index, and every one after that
+  // starts on the sector after the previous one.
+
+  uint32_t Sector = (sizeof(ArchiveHeaderStruct) + (Count * sizeof(ArchiveEntryStruct)) + 511) / 512;
+
+  for (int i = 0; i < Count; i++) {
+
+    Modules[i].Entry.Offset = Sector;
+    Sector += (Modules[i].Entry.Length + 511) / 512;
+
+  }
+
+  ArchiveEntryStruct* Index = calloc((Count > 0) ? Count : 1, sizeof(ArchiveEntryStruct));
+
+  for (int i = 0; i < Count; i++) {
+
+    Index[i] = Modules[i].Entry;
+
+  }
+
+  ArchiveHeaderStruct Header = {ArchiveSignature, ArchiveVersion, (uint16_t)Count, Sector,
+                                Checksum(Index, Count * sizeof(ArchiveEntryStruct))};
+
+  // Finally, write everything out, padding every module (and the index) to a whole sector.
+
+  FILE* Output = fopen(argv[1], "wb");
+
+  if (Output == NULL) {
+
+    fprintf(stderr, "Pack: Couldn't create '%s'.\n", argv[1]);
+    return 1;
+
+  }
+
+  static const unsigned char Padding[512];
+  size_t IndexSize = sizeof(ArchiveHeaderStruct) + (Count * sizeof(ArchiveEntryStruct));
+
+  // If any of these writes fail (for example, if the disk is full), the archive is cut short, and the bootloader would
+  // only reject it when booting, so this has to fail the build instead.
+
+  size_t IndexPadding = (512 - (IndexSize % 512)) % 512;
+  int Failed = 0;
+
+  if (fwrite(&Header, sizeof(ArchiveHeaderStruct), 1, Output) != 1) Failed = 1;
+  if (fwrite(Index, sizeof(ArchiveEntryStruct), Count, Output) != (size_t)Count) Failed = 1;
+  if (fwrite(Padding, 1, IndexPadding, Output) != IndexPadding) Failed = 1;
+
+  for (int i = 0; i < Count; i++) {
+
+    size_t ModulePadding = (512 - (Modules[i].Entry.Length % 512)) % 512;
+
+    if (fwrite(Modules[i].Data, 1, Modules[i].Entry.Length, Output) != Modules[i].Entry.Length) Failed = 1;
+    if (fwrite(Padding, 1, ModulePadding, Output) != ModulePadding) Failed = 1;
+    free(Modules[i].Data);
+
+  }
+
+  if (fclose(Output) != 0) Failed = 1;
+
+  if (Failed != 0) {
+
+    fprintf(stderr, "Pack: Couldn't write '%s'.\n", argv[1]);
+    return 1;
+
+  }
+
+  free(Index);
+  free(Modules);
+
+  return 0;
+
+}